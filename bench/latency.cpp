@@ -0,0 +1,170 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#elif defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#endif
+
+#include "pipeline.h"
+
+using namespace simplelog;
+
+// Latency of single logs, issued at a fixed rate.
+// Usage: simplelog-bench-latency [logs per second] [seconds per configuration]
+//
+// Each log is scheduled at a fixed interval. Its "service" time is measured from the moment it's
+// actually issued, and its "response" time from the moment it was scheduled: when a log stalls,
+// the logs delayed behind it account for the wait (coordinated omission correction).
+namespace {
+// Timestamp counter, or the steady clock where there is none
+uint64_t ticks()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_lfence();
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+}
+
+double ticksPerNanosecond()
+{
+    using namespace std::chrono;
+    auto begin = steady_clock::now();
+    uint64_t t0 = ticks();
+    std::this_thread::sleep_for(milliseconds(200));
+    uint64_t t1 = ticks();
+    auto end = steady_clock::now();
+    return (t1 - t0) / static_cast<double>(duration_cast<nanoseconds>(end - begin).count());
+}
+
+// Log-linear histogram of nanoseconds, as HdrHistogram: values are counted in 128 buckets per
+// power of 2, which keeps percentiles within 1% of the actual values.
+class histogram
+{
+public:
+    histogram() : m_counts((64 - m_subBits + 1) << m_subBits), m_total(0), m_max(0) {}
+
+    void record(uint64_t value)
+    {
+        m_counts[index(value)]++;
+        m_total++;
+        m_max = std::max(m_max, value);
+    }
+
+    // Highest value of the bucket holding the given percentile
+    uint64_t percentile(double p) const
+    {
+        const uint64_t rank = static_cast<uint64_t>(p / 100 * m_total + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_counts.size(); i++) {
+            seen += m_counts[i];
+            if (seen >= std::max<uint64_t>(rank, 1))
+                return std::min(highest(i), m_max);
+        }
+        return m_max;
+    }
+    uint64_t max() const { return m_max; }
+
+private:
+    static const unsigned m_subBits = 7;
+
+    static size_t index(uint64_t value)
+    {
+        if (value < (1u << m_subBits))
+            return static_cast<size_t>(value);
+        unsigned msb = m_subBits;
+        while (msb < 63 && value >> (msb + 1))
+            msb++;
+        const unsigned shift = msb - m_subBits;
+        const uint64_t sub = (value >> shift) - (1u << m_subBits);
+        return ((shift + 1) << m_subBits) + static_cast<size_t>(sub);
+    }
+    static uint64_t highest(size_t index)
+    {
+        if (index < (1u << m_subBits))
+            return index;
+        const unsigned shift = static_cast<unsigned>(index >> m_subBits) - 1;
+        const uint64_t sub = (index & ((1u << m_subBits) - 1)) + (1u << m_subBits);
+        return ((sub + 1) << shift) - 1;
+    }
+
+    std::vector<uint64_t> m_counts;
+    uint64_t m_total;
+    uint64_t m_max;
+};
+
+void print(const char * name, const char * kind, const histogram & h)
+{
+    printf("%-28s %-9s %9llu %9llu %9llu %9llu\n", name, kind,
+           static_cast<unsigned long long>(h.percentile(50)),
+           static_cast<unsigned long long>(h.percentile(99)),
+           static_cast<unsigned long long>(h.percentile(99.9)),
+           static_cast<unsigned long long>(h.max()));
+}
+
+void run(const bench::pipeline & p, double rate, double seconds, double ticksPerNs)
+{
+    module * m = bench::getModule(p);
+    const double interval = 1e9 / rate * ticksPerNs;
+    const uint64_t count = static_cast<uint64_t>(rate * seconds);
+    histogram service;
+    histogram response;
+
+    const uint64_t start = ticks();
+    for (uint64_t i = 0; i < count; i++) {
+        const uint64_t scheduled = start + static_cast<uint64_t>(i * interval);
+        uint64_t issued;
+        while ((issued = ticks()) < scheduled) {}
+        bench::log(m, p.entry, static_cast<int>(i));
+        const uint64_t end = ticks();
+        service.record(static_cast<uint64_t>((end - issued) / ticksPerNs));
+        response.record(static_cast<uint64_t>((end - scheduled) / ticksPerNs));
+    }
+    m->flush();
+
+    std::string name = std::string(bench::apiName(p.entry)) + "/" + (p.sink + strlen("bench-"))
+                       + "/" + p.formatter + "/" + (p.async ? "async" : "sync");
+    print(name.c_str(), "service", service);
+    print("", "response", response);
+}
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    const double rate = argc > 1 ? atof(argv[1]) : 100000;
+    const double seconds = argc > 2 ? atof(argv[2]) : 2;
+    if (rate <= 0 || seconds <= 0) {
+        fprintf(stderr, "Usage: %s [logs per second] [seconds per configuration]\n", argv[0]);
+        return 1;
+    }
+    bench::registerLoggers();
+    const double ticksPerNs = ticksPerNanosecond();
+
+    printf("%.0f logs/s, latencies in ns\n", rate);
+    printf("%-28s %-9s %9s %9s %9s %9s\n", "configuration", "", "p50", "p99", "p99.9", "max");
+    for (bench::api entry : { bench::api::c, bench::api::cpp }) {
+        for (const char * sink : { "bench-null", "bench-file" }) {
+            for (bool async : { false, true }) {
+                bench::pipeline p{ entry, sink, "Default", async, LOG_LEVEL_VERBOSE };
+                run(p, rate, seconds, ticksPerNs);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "pipeline.h"
+
+using namespace simplelog;
+
+namespace {
+void run(benchmark::State & state, const bench::pipeline & p)
+{
+    module * m = bench::getModule(p);
+    int i = 0;
+    for (auto _ : state)
+        bench::log(m, p.entry, i++);
+    state.SetItemsProcessed(state.iterations());
+    // Asynchronous logs are only measured on the caller side, they are written out of the timing
+    if (state.thread_index() == 0)
+        m->flush();
+}
+
+void registerBenchmarks()
+{
+    using bench::api;
+    for (api entry : { api::c, api::c_compiled, api::cpp }) {
+        for (const char * sink : { "bench-null", "bench-file", "bench-stdout" }) {
+            for (const char * formatter : { "Default", "Null" }) {
+                for (bool async : { false, true }) {
+                    bench::pipeline p{ entry, sink, formatter, async, LOG_LEVEL_VERBOSE };
+                    std::string name = std::string("log/") + bench::apiName(entry)
+                                       + "/" + (sink + strlen("bench-")) + "/" + formatter + "/"
+                                       + (async ? "async" : "sync");
+                    benchmark::RegisterBenchmark(name.c_str(), run, p)
+                            ->ThreadRange(1, 64)
+                            ->UseRealTime();
+                }
+            }
+        }
+        // Logs below the module level
+        bench::pipeline p{ entry, "bench-null", "Default", false, LOG_LEVEL_WARNING };
+        std::string name = std::string("filtered/") + bench::apiName(entry);
+        benchmark::RegisterBenchmark(name.c_str(), run, p)->ThreadRange(1, 64)->UseRealTime();
+    }
+}
+} // namespace
+
+int main(int argc, char ** argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+
+    bench::registerLoggers();
+    registerBenchmarks();
+
+    // Results are displayed on stderr, since stdout is one of the benchmarked sinks.
+    // --benchmark_out=<file> --benchmark_out_format=json writes them as json.
+    benchmark::ConsoleReporter display(benchmark::ConsoleReporter::OO_None);
+    display.SetOutputStream(&std::cerr);
+    display.SetErrorStream(&std::cerr);
+    benchmark::RunSpecifiedBenchmarks(&display);
+    benchmark::Shutdown();
+    return 0;
+}
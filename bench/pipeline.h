@@ -0,0 +1,116 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_BENCH_PIPELINE_H
+#define SIMPLELOG_BENCH_PIPELINE_H
+
+#include <cstdlib>
+#include <mutex>
+#include <simplelog/logger.h>
+#include <string>
+
+namespace bench {
+
+using namespace simplelog;
+
+// Sink discarding logs, to measure simplelog alone
+class null_logger : public logger
+{
+public:
+    null_logger(const std::string & tag) : logger(tag) {}
+
+protected:
+    virtual void logRaw(log_level, const char *, size_t) override {}
+};
+
+class null_logger_factory : public logger_factory
+{
+public:
+    null_logger_factory() : logger_factory("BenchNull") {}
+    virtual std::shared_ptr<logger> getLogger(const std::string & tag, const std::string &) override
+    {
+        return std::make_shared<null_logger>(tag);
+    }
+    static null_logger_factory & instance()
+    {
+        static null_logger_factory factory;
+        return factory;
+    }
+};
+
+enum class api
+{
+    c,          // _simplelog_log, formatted by vsnprintf
+    c_compiled, // _simplelog_logf, as used by the C macros
+    cpp         // module::log, as used by the C++ macros
+};
+inline const char * apiName(api entry)
+{
+    switch (entry) {
+        case api::c: return "c";
+        case api::c_compiled: return "c_compiled";
+        default: return "cpp";
+    }
+}
+
+// Loggers targeted by benchmarks: "bench-null", "bench-file" and "bench-stdout".
+// Files are written to /dev/null by default, not to fill a disk with benchmark logs.
+inline void registerLoggers()
+{
+    null_logger_factory::instance();
+    const char * path = getenv("SIMPLELOG_BENCH_FILE");
+    SLOG_REGISTER_LOGGER("bench-null", "BenchNull");
+    SLOG_REGISTER_LOGGER("bench-file", "File", path ? path : "/dev/null");
+    SLOG_REGISTER_LOGGER("bench-stdout", "Stdout");
+}
+
+struct pipeline
+{
+    api entry;
+    const char * sink;
+    const char * formatter;
+    bool async;
+    int level;
+};
+
+// Module of a pipeline, created with its own tag on first use
+inline module * getModule(const pipeline & p)
+{
+    // Formatter, engine and level are global settings, only read when a module is created
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string tag = std::string("bench.") + p.sink + "." + p.formatter + "."
+                      + (p.async ? "async." : "sync.") + std::to_string(p.level);
+    SLOG_FORMATTER(p.formatter);
+    SLOG_SET_ASYNC(p.async);
+    SLOG_DEFAULT_LEVEL(p.level);
+    auto m = reinterpret_cast<module *>(_simplelog_create(tag.c_str(), p.sink));
+    SLOG_DEFAULT_LEVEL(LOG_LEVEL_VERBOSE);
+    return m;
+}
+
+// Log a typical message through an entry point
+inline void log(module * m, api entry, int i)
+{
+    switch (entry) {
+        case api::c:
+            _simplelog_log(m, LOG_LEVEL_INFO, __FILE__, __func__, __LINE__,
+                           "request %d from %s took %.3f ms", i, "client", 0.5);
+            break;
+        case api::c_compiled: {
+            static void * format = nullptr;
+            _simplelog_logf(m, &format, LOG_LEVEL_INFO, __FILE__, __func__, __LINE__,
+                            "request %d from %s took %.3f ms", i, "client", 0.5);
+            break;
+        }
+        case api::cpp:
+            m->log(log_level::info, __FILE__, __func__, __LINE__,
+                   _SLOG_FORMAT("request {} from {} took {:.3f} ms"), i, "client", 0.5);
+            break;
+    }
+}
+
+} // namespace bench
+
+#endif
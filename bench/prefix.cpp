@@ -0,0 +1,148 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <simplelog/logger.h>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace simplelog;
+
+namespace {
+const int iterations = 1000000;
+
+// Default formatter prefix as rendered before the rendering module, as a reference.
+// Called through iformatter like the default formatter, so that only the rendering differs.
+class legacy_prefix : public iformatter
+{
+public:
+    void format(const log_metadata &, memory_buffer &, const char *, va_list) override {}
+    void format(const log_metadata & metadata, string_view, memory_buffer & formatted) override
+    {
+        formatted.push_back('[');
+        formatted.push_back("XPEWIDV"[static_cast<int>(metadata.level)]);
+        formatted.push_back(']');
+        if (metadata.hour != m_hour || metadata.minute != m_minute || metadata.second != m_second) {
+            m_hour = metadata.hour;
+            m_minute = metadata.minute;
+            m_second = metadata.second;
+            m_seconds.clear();
+            m_seconds.push_back('[');
+            appendDecimal(m_seconds, metadata.year, 4);
+            m_seconds.push_back('-');
+            appendDecimal(m_seconds, metadata.month, 2);
+            m_seconds.push_back('-');
+            appendDecimal(m_seconds, metadata.day, 2);
+            m_seconds.push_back(' ');
+            appendDecimal(m_seconds, metadata.hour, 2);
+            m_seconds.push_back(':');
+            appendDecimal(m_seconds, metadata.minute, 2);
+            m_seconds.push_back(':');
+            appendDecimal(m_seconds, metadata.second, 2);
+            m_seconds.push_back('.');
+        }
+        if (metadata.millisecond != m_millisecond) {
+            m_millisecond = metadata.millisecond;
+            m_milliseconds.clear();
+            appendDecimal(m_milliseconds, metadata.millisecond, 3);
+            m_milliseconds.push_back(']');
+        }
+        formatted.append(m_seconds.data(), m_seconds.data() + m_seconds.size());
+        formatted.append(m_milliseconds.data(), m_milliseconds.data() + m_milliseconds.size());
+        formatted.push_back('[');
+        appendDecimal(formatted, metadata.tid);
+        formatted.push_back(']');
+        formatted.push_back('[');
+        formatted.append(metadata.tag, metadata.tag + strlen(metadata.tag));
+        formatted.push_back(']');
+        formatted.push_back(' ');
+    }
+
+private:
+    template<typename T>
+    void appendDecimal(memory_buffer & buffer, T decimal, int padding = -1)
+    {
+        fmt::format_int i(decimal);
+        for (int i = padding - 1; i > 0 && decimal < pow(10, i); i--)
+            buffer.push_back('0');
+        buffer.append(i.data(), i.data() + i.size());
+    }
+
+    int m_hour = -1;
+    int m_minute = -1;
+    int m_second = -1;
+    int m_millisecond = -1;
+    memory_buffer m_seconds;
+    memory_buffer m_milliseconds;
+};
+
+// Metadata of successive logs, msPerLog apart, starting a few seconds before a new year
+std::vector<log_metadata> makeMetadata(double msPerLog)
+{
+    std::vector<log_metadata> logs;
+    const time_t start = 1609459190; // 2020-12-31 23:59:50 UTC
+    for (int i = 0; i < 8192; i++) {
+        long ms = static_cast<long>(i * msPerLog);
+        time_t t = start + ms / 1000;
+        tm utc;
+        gmtime_r(&t, &utc);
+        logs.push_back(log_metadata{ "bench", log_level::info, os::getThreadId(), __FILE__,
+                                     __func__, __LINE__, utc.tm_year + 1900, utc.tm_mon + 1,
+                                     utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec,
+                                     static_cast<int>(ms % 1000),
+                                     static_cast<int>(ms % 1000) * 1000000,
+                                     static_cast<long long>(t),
+                                     timestamp_mode::local,
+                                     timestamp_precision::ms });
+    }
+    return logs;
+}
+
+double measure(iformatter & formatter, const std::vector<log_metadata> & logs)
+{
+    memory_buffer buffer;
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        buffer.clear();
+        formatter.format(logs[i % logs.size()], string_view(), buffer);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / iterations;
+}
+} // namespace
+
+int main()
+{
+    std::shared_ptr<iformatter> legacy = std::make_shared<legacy_prefix>();
+    auto formatter = formatter_factory::get("Default");
+
+    printf("%-24s %10s %10s\n", "interval between logs", "legacy", "render");
+    for (double msPerLog : { 0.25, 1.0, 1000.0 }) {
+        const std::vector<log_metadata> logs = makeMetadata(msPerLog);
+
+        // Both prefixes must be identical
+        for (auto & m : logs) {
+            memory_buffer expected;
+            memory_buffer actual;
+            legacy->format(m, string_view(), expected);
+            formatter->format(m, string_view(), actual);
+            std::string e(expected.data(), expected.size());
+            std::string a(actual.data(), actual.size());
+            if (e != a) {
+                fprintf(stderr, "prefix mismatch:\n%s\n%s\n", e.c_str(), a.c_str());
+                return 1;
+            }
+        }
+
+        double legacyTime = measure(*legacy, logs);
+        double renderTime = measure(*formatter, logs);
+        printf("%-21.2f ms %7.1f ns %7.1f ns\n", msPerLog, legacyTime, renderTime);
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+option(SIMPLELOG_BUILD_BENCH "Build simplelog benchmarks." OFF)
+
+if (SIMPLELOG_BUILD_BENCH)
+  set(BENCHS
+    format
+    latency
+    prefix
+  )
+
+  foreach(bench ${BENCHS})
+    add_executable(simplelog-bench-${bench} bench/${bench}.cpp)
+    target_link_libraries(simplelog-bench-${bench} simplelog::simplelog)
+    # C++ 17 so that format strings are compiled rather than only checked
+    set_target_properties(simplelog-bench-${bench} PROPERTIES CXX_STANDARD 17)
+  endforeach()
+
+  # Whole logging pipeline, with google benchmark
+  set(BENCHMARK_ENABLE_TESTING OFF)
+  set(BENCHMARK_ENABLE_INSTALL OFF)
+  fetch(benchmark "https://github.com/google/benchmark.git" "main")
+  add_executable(simplelog-bench bench/pipeline.cpp)
+  target_link_libraries(simplelog-bench simplelog::simplelog benchmark::benchmark)
+  set_target_properties(simplelog-bench PROPERTIES CXX_STANDARD 17)
+
+  # Results as json, to be compared between versions
+  add_custom_target(simplelog-bench-json
+    COMMAND simplelog-bench --benchmark_out=${CMAKE_BINARY_DIR}/simplelog-bench.json
+                            --benchmark_out_format=json > ${CMAKE_BINARY_DIR}/simplelog-bench.log
+    DEPENDS simplelog-bench
+    USES_TERMINAL
+  )
+endif()
@@ -3,8 +3,8 @@ option(SIMPLELOG_ASSERT_ENABLED "Enable or disable asserts." ON)
 set(SIMPLELOG_LOG_LEVEL "LOG_LEVEL_VERBOSE" CACHE STRING "The log level.")
 set_property(CACHE SIMPLELOG_LOG_LEVEL PROPERTY STRINGS LOG_LEVEL_VERBOSE LOG_LEVEL_DEBUG LOG_LEVEL_INFO LOG_LEVEL_WARNING LOG_LEVEL_ERROR LOG_LEVEL_PANIC LOG_LEVEL_DISABLED)
 
-# Log max length
-set(SIMPLELOG_MAX_LINE_LENGTH "256" CACHE STRING "The max length of each log entry.")
+# Size of the inline formatting buffer, longer lines are formatted in a reusable per-thread buffer
+set(SIMPLELOG_MAX_LINE_LENGTH "256" CACHE STRING "The inline buffer size of each log entry.")
 
 # Asynchronous logging max queue size
 set(SIMPLELOG_ASYNCHRONOUS_MAX_QUEUE_SIZE "16384" CACHE STRING "The max queue size for asynchronous logging.")
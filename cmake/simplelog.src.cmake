@@ -3,13 +3,24 @@ set(SRCS
   src/formatters/null_formatter.cpp
   src/loggers/file/file_logger.cpp
   src/loggers/stdout/stdout_logger.cpp
+  src/core/allocator.cpp
+  src/core/async_backend.cpp
   src/core/async_consumer.cpp
+  src/core/call_site.cpp
   src/core/config.cpp
   src/core/config_parser.cpp
+  src/core/crash_handler.cpp
   src/core/formatter.cpp
+  src/core/load_shedding.cpp
   src/core/logger.cpp
   src/core/logger_engine.cpp
+  src/core/printf_format.cpp
+  src/core/render.cpp
+  src/core/sampler.cpp
+  src/core/site_profiler.cpp
+  src/core/stage_timing.cpp
   src/core/sync_consumer.cpp
+  src/core/thread_identity.cpp
 )
 
 include_directories(
@@ -1,11 +1,41 @@
 if (BUILD_TESTING)
+  # The C logging macros are tested as well
+  enable_language(C)
   set(TESTS
+    tests/async_backend.cpp
+    tests/call_site.cpp
     tests/config.cpp
     tests/config_parser.cpp
+    tests/crash_handler.cpp
+    tests/fork.cpp
+    tests/formatter.cpp
+    tests/load_shedding.cpp
+    tests/metrics.cpp
+    tests/sampler.cpp
+    tests/site_profiler.cpp
+    tests/stage_timing.cpp
+  )
+  # Tests expanding the logging macros configure the process wide loggers and levels,
+  # apart from the tests of the configuration itself
+  set(MACRO_TESTS
+    tests/compiled_format.cpp
+    tests/logger.cpp
+    tests/logger_c.c
+    tests/max_level.cpp
+    tests/runtime_format.cpp
   )
 
   fetch(googletest "https://github.com/google/googletest.git" "master")
   add_executable(simplelog-tests ${TESTS})
   target_link_libraries(simplelog-tests simplelog::simplelog gtest gtest_main gmock)
+  # The file logger is tested directly by the crash handler tests
+  target_include_directories(simplelog-tests PRIVATE src/loggers/file)
   set_target_properties(simplelog-tests PROPERTIES CXX_STANDARD 14)
+  add_executable(simplelog-macro-tests ${MACRO_TESTS})
+  target_link_libraries(simplelog-macro-tests simplelog::simplelog gtest gtest_main gmock)
+  set_target_properties(simplelog-macro-tests PROPERTIES CXX_STANDARD 14)
+  # Allocations are counted by replacing malloc for the whole process
+  add_executable(simplelog-allocation-tests tests/allocation.cpp)
+  target_link_libraries(simplelog-allocation-tests simplelog::simplelog gtest gtest_main gmock)
+  set_target_properties(simplelog-allocation-tests PROPERTIES CXX_STANDARD 14)
 endif()
@@ -10,6 +10,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 /**
  * Update simplelog configuration given ini file located at path.
@@ -174,6 +175,291 @@
         _simplelog_default_async_logging(async);                                                   \
     } while (0)
 
+/**
+ * Macro to route simplelog internal allocations through custom functions.
+ * \c alloc is called as \c alloc(size,ctx) and \c release as \c release(ptr,ctx).
+ * Default functions are malloc and free.
+ *
+ * It should be called at program startup, at the beginning of main function, before any log.
+ * It should be called only one time.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * static void * my_alloc(size_t size, void * ctx) { return my_arena_alloc(ctx, size); }
+ * static void my_release(void * ptr, void * ctx) { my_arena_free(ctx, ptr); }
+ * int main(int argc, char ** argv)
+ * {
+ *     SLOG_SET_ALLOCATOR(my_alloc, my_release, &my_arena);
+ *
+ *     SLOGI("This is an info log");
+ *     return 0;
+ * }
+ * @endcode
+ */
+#define SLOG_SET_ALLOCATOR(alloc, release, ctx)                                                    \
+    do {                                                                                           \
+        _simplelog_set_allocator(alloc, release, ctx);                                             \
+    } while (0)
+
+/**
+ * Macro to enable the real-time mode, for processes which must not allocate memory after
+ * their initialization.
+ *
+ * A pool of \c pool_size bytes is allocated immediately (through #SLOG_SET_ALLOCATOR functions if
+ * any), and is then used for all internal allocations done while logging: long messages
+ * formatting, asynchronous queue. Asynchronous logs which can't fit in the pool are dropped
+ * as an overflow, and the program aborts with an error message if a message can't be formatted
+ * within the pool. The pool is made of blocks of 64KiB, so messages can't exceed that size.
+ * Smaller allocations are served from blocks split into chunks of 64B to 16KiB.
+ *
+ * Modules are still allocated when logging for the first time, and configuration when calling
+ * configuration macros: they should be done during the initialization.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * int main(int argc, char ** argv)
+ * {
+ *     SLOG_CONFIG("/etc/my_service/simplelog.ini");
+ *     SLOG_REALTIME(4 * 1024 * 1024);
+ *
+ *     SLOGI("This log doesn't allocate memory");
+ *     return 0;
+ * }
+ * @endcode
+ */
+#define SLOG_REALTIME(pool_size)                                                                   \
+    do {                                                                                           \
+        _simplelog_realtime(pool_size);                                                            \
+    } while (0)
+
+/**
+ * Macro to name the calling thread in its logs.
+ *
+ * Logs of a named thread are identified by its id followed by its name, ie. "[1234:io-worker-3]"
+ * with the default formatter. Names longer than 47 characters are truncated, and a \c NULL or
+ * empty name removes the name of the thread.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * void * worker(void * arg)
+ * {
+ *     SLOG_SET_THREAD_NAME("io-worker-3");
+ *
+ *     SLOGI("This log is identified by the thread name");
+ *     return NULL;
+ * }
+ * @endcode
+ */
+#define SLOG_SET_THREAD_NAME(name)                                                                 \
+    do {                                                                                           \
+        _simplelog_set_thread_name(name);                                                          \
+    } while (0)
+
+/**
+ * Counters of an engine or a logger, as reported by #SLOG_METRICS.
+ *
+ * An engine handles the logs of all tags sharing the same configuration (level, formatter,
+ * synchronous or asynchronous, loggers), and writes them to its loggers.
+ * Counters are totals since the engine or logger creation, except the queue depth.
+ */
+struct simplelog_metrics
+{
+    /** Logger name, or engine description: "<level> <formatter> <sync|async> [<loggers>]" */
+    const char * name;
+    /** 1 for an engine, 0 for a logger */
+    int engine;
+    /** Lines accepted by an engine, or written to a logger */
+    unsigned long long records;
+    unsigned long long bytes;
+    /** Lines dropped by an asynchronous engine, because its queue was full */
+    unsigned long long drops;
+    unsigned long long flushes;
+    /** Lines currently queued by an asynchronous engine, and the maximum so far */
+    unsigned long long queue_depth;
+    unsigned long long queue_max_depth;
+    /** Loggers write latency, sampled on 1 write out of 64 */
+    unsigned long long write_samples;
+    unsigned long long write_total_ns;
+    unsigned long long write_max_ns;
+};
+
+/**
+ * Macro to take a snapshot of simplelog metrics.
+ *
+ * \c callback is called as \c callback(metrics,ctx) for each engine and each logger, after the
+ * snapshot is taken: it may log. Counters are updated without synchronization, so that they
+ * don't slow logging down: a snapshot may miss the last logs of other threads.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * static void export_metrics(const struct simplelog_metrics * m, void * ctx)
+ * {
+ *     my_exporter_add(ctx, m->name, "records", m->records);
+ *     my_exporter_add(ctx, m->name, "drops", m->drops);
+ * }
+ * void on_scrape(void * exporter)
+ * {
+ *     SLOG_METRICS(export_metrics, exporter);
+ * }
+ * @endcode
+ */
+#define SLOG_METRICS(callback, ctx)                                                                \
+    do {                                                                                           \
+        _simplelog_metrics(callback, ctx);                                                         \
+    } while (0)
+
+/**
+ * Macro to count the lines and bytes logged by each call site, to find the noisiest logs.
+ *
+ * Counting is disabled by default, and costs a table lookup per line when enabled. When
+ * \c summary_interval isn't 0, the 5 noisiest sites are logged with the tag "simplelog" every
+ * \c summary_interval seconds. The \c Site_profiling and \c Site_summary keys of the
+ * \c [general] ini section set the same values.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * void main()
+ * {
+ *     SLOG_SET_SITE_PROFILING(1, 60);
+ * }
+ * @endcode
+ */
+#define SLOG_SET_SITE_PROFILING(enable, summary_interval)                                         \
+    do {                                                                                           \
+        _simplelog_site_profiling(enable, summary_interval);                                       \
+    } while (0)
+
+/**
+ * Counters of a call site, as reported by #SLOG_TOP_SITES.
+ */
+struct simplelog_site
+{
+    const char * file;
+    int line;
+    const char * tag;
+    int level;
+    /** Lines and bytes (as formatted) logged since counting started */
+    unsigned long long records;
+    unsigned long long bytes;
+};
+
+/**
+ * Macro to report the call sites which logged the most bytes, since #SLOG_SET_SITE_PROFILING.
+ *
+ * \c callback is called as \c callback(site,ctx) for at most \c count sites, noisiest first.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * static void print_site(const struct simplelog_site * s, void * ctx)
+ * {
+ *     printf("%s:%d %llu bytes\n", s->file, s->line, s->bytes);
+ * }
+ * void dump()
+ * {
+ *     SLOG_TOP_SITES(10, print_site, NULL);
+ * }
+ * @endcode
+ */
+#define SLOG_TOP_SITES(count, callback, ctx)                                                       \
+    do {                                                                                           \
+        _simplelog_top_sites(count, callback, ctx);                                                \
+    } while (0)
+
+/**
+ * Macro to time the stages of 1 log out of \c sampling, 0 to stop timing (default).
+ *
+ * Logs that aren't timed only cost a counter decrement. The \c Stage_timing key of the
+ * \c [general] ini section sets the same value.
+ */
+#define SLOG_SET_STAGE_TIMING(sampling)                                                            \
+    do {                                                                                           \
+        _simplelog_stage_timing(sampling);                                                         \
+    } while (0)
+
+/**
+ * Durations of a stage of the timed logs, as reported by #SLOG_STAGE_TIMINGS.
+ */
+struct simplelog_stage
+{
+    /**
+     * Stage name:
+     * - "message": user message formatting
+     * - "line": formatter (metadata and message)
+     * - "lock": wait for the engine lock
+     * - "consume": queueing by asynchronous engines, loggers writes by synchronous ones
+     * - "queue": wait in the asynchronous queue
+     * - "write": loggers writes by the asynchronous writer thread
+     */
+    const char * name;
+    unsigned long long samples;
+    unsigned long long total_ns;
+    unsigned long long max_ns;
+    /** Histogram: buckets[i] counts the durations from 2^i to 2^(i+1)-1 ns */
+    unsigned long long buckets[32];
+};
+
+/**
+ * Macro to report the durations of each stage of the logs timed since #SLOG_SET_STAGE_TIMING.
+ *
+ * \c callback is called as \c callback(stage,ctx) for each stage, in the order of a log.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("MyTag");
+ * static void print_stage(const struct simplelog_stage * s, void * ctx)
+ * {
+ *     if (s->samples)
+ *         printf("%s: %llu ns average\n", s->name, s->total_ns / s->samples);
+ * }
+ * void dump()
+ * {
+ *     SLOG_STAGE_TIMINGS(print_stage, NULL);
+ * }
+ * @endcode
+ */
+#define SLOG_STAGE_TIMINGS(callback, ctx)                                                          \
+    do {                                                                                           \
+        _simplelog_stage_timings(callback, ctx);                                                   \
+    } while (0)
+
+/**
+ * Macro to shed logs of asynchronous engines while their queue is under pressure.
+ *
+ * From \c verbose percents of the queue filled, verbose logs are dropped before being formatted,
+ * then debug logs from \c debug percents, and info logs from \c info percents. A level is
+ * restored once the queue drains below half of its watermark, and each change is logged by the
+ * writer thread. 0 disables a step, and 0,0,0 disables shedding (default). The
+ * \c Load_shedding key of the \c [general] ini section sets the same watermarks, i.e.
+ * \c 50,70,90.
+ */
+#define SLOG_SET_LOAD_SHEDDING(verbose, debug, info)                                               \
+    do {                                                                                           \
+        _simplelog_load_shedding(verbose, debug, info);                                            \
+    } while (0)
+
+/**
+ * Macro to install a handler of fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT), or to
+ * restore the previous handlers.
+ *
+ * On a crash, the logs buffered by the loggers and the logs still queued by asynchronous
+ * engines are written to the loggers files, followed by a fatal line and a raw backtrace, using
+ * async-signal-safe \c write(2) calls only. Logs buffered by the stdout stream are only recovered
+ * on glibc. The signal is then raised again to the previous
+ * handler. Failed asserts flush all engines before aborting, and are then reported the same way.
+ * The \c Crash_handler key of the \c [general] ini section sets the same value (default 0).
+ * Not supported on Windows.
+ */
+#define SLOG_SET_CRASH_HANDLER(enable)                                                             \
+    do {                                                                                           \
+        _simplelog_crash_handler(enable);                                                          \
+    } while (0)
+
 /**
  * Macro to declare a tag.
  *
@@ -197,11 +483,43 @@
  * @code
  * SLOG_DECLARE_MODULE("MyTag", "Console");
  * @endcode
+ *
+ * A maximum log level can also be given with #SLOG_MAX_LEVEL, so that the optimizer removes all
+ * logs above that level from the source file.
+ *
+ * @code
+ * SLOG_DECLARE_MODULE("MyTag", SLOG_MAX_LEVEL(LOG_LEVEL_WARNING));
+ * SLOG_DECLARE_MODULE("MyTag", "Console", SLOG_MAX_LEVEL(LOG_LEVEL_WARNING));
+ * @endcode
  */
 #define SLOG_DECLARE_MODULE(...)                                                                   \
-    _SLOG_DECLARE_MODULE_IMPL(__VA_ARGS__, _SLOG_DECLARE_MODULE_2, _SLOG_DECLARE_MODULE_1)         \
+    _SLOG_DECLARE_MODULE_IMPL(__VA_ARGS__, _SLOG_DECLARE_MODULE_4, _SLOG_DECLARE_MODULE_3,         \
+                              _SLOG_DECLARE_MODULE_2, _SLOG_DECLARE_MODULE_1)                      \
     (__VA_ARGS__)
 
+/**
+ * Build time maximum log level of a module, to be given to #SLOG_DECLARE_MODULE.
+ * Logs above that level are compiled out by the optimizer in that source file, in addition to the
+ * global #LOG_LEVEL limit. It allows to keep verbose logs in most modules while removing them from
+ * performance critical ones.
+ *
+ * Unlike #LOG_LEVEL, the module maximum level is a constant rather than a preprocessor value: logs
+ * above it are still compiled, and their format strings checked, under an always false condition.
+ * Their arguments are never evaluated, and optimized builds don't contain them.
+ * Unoptimized builds (-O0) may still contain their code and call sites.
+ *
+ * @code
+ * #include <simplelog/logger.h>
+ * SLOG_DECLARE_MODULE("HotPath", SLOG_MAX_LEVEL(LOG_LEVEL_WARNING));
+ * void my_class::process()
+ * {
+ *     SLOGD("This log is compiled out");
+ *     SLOGW("This log is kept");
+ * }
+ * @endcode
+ */
+#define SLOG_MAX_LEVEL(level) 0, (level)
+
 /**
  * \def LOG_LEVEL
  * Current log levels are:
@@ -274,6 +592,22 @@
 #define SLOGP(...)
 #endif
 
+/**
+ * Log at most \c per_second times per second from this call site, as a token bucket allowing
+ * bursts of \c per_second logs. Consecutive identical messages are folded.
+ *
+ * Dropped logs return before any formatting. The count of dropped logs, and of folded
+ * duplicates, is written with the next log of the call site, or when the one second folding
+ * window expires if the site doesn't log again, and at the latest on flush or exit. Logs of the
+ * tags listed in the \c [ratelimit] ini section are limited the same way, from each of their
+ * call sites.
+ *
+ * @code
+ * SLOG_RATE_LIMIT(LOG_LEVEL_ERROR, 10, "connection to {} failed: {}", host, error);
+ * @endcode
+ */
+#define SLOG_RATE_LIMIT(level, per_second, ...) _SLOG_RATE_LIMIT(level, per_second, __VA_ARGS__)
+
 /**
  * Abort without condition.
  * May contain a custom message with optional arguments.
@@ -358,18 +692,34 @@
 #define SLOG_ASSERT_TYPE_ABORT 0
 #define SLOG_ASSERT_TYPE_PRINT 1
 
-// Log max line size
+// C++ format strings must be literals, checked at build time.
+// Define LOG_RUNTIME_FORMAT to use other format strings, parsed on each log.
+// #define LOG_RUNTIME_FORMAT
+
+// Inline line buffer size, longer lines spill to a per-thread buffer
 #ifndef LOG_MAX_LINE_LENGTH
 #define LOG_MAX_LINE_LENGTH 256
 #endif
 
-// Asynchronous engine max queue size
+// Asynchronous engine max queue size: max count of logs not written yet by each asynchronous
+// engine, ie. each tag routing. Engines share the writer thread, not this limit.
 #ifndef LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE
 #define LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE 16384
 #endif
 
 // **** Private impl **** //
 
+// Rate limiting and duplicates folding state of a log call site, zero initialized
+struct _simplelog_site
+{
+    long long next;
+    long long until;
+    unsigned long long hash;
+    unsigned long long repeats;
+    unsigned long long dropped;
+    int pending;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -380,9 +730,38 @@ void _simplelog_register_logger(const char * name, const char * type, const char
 void _simplelog_default_loggers(const char * loggers_names);
 void _simplelog_default_log_level(int level);
 void _simplelog_default_async_logging(int async);
+void _simplelog_set_allocator(void * (*alloc)(size_t size, void * ctx),
+                              void (*release)(void * ptr, void * ctx), void * ctx);
+int _simplelog_realtime(size_t pool_size);
+void _simplelog_set_thread_name(const char * name);
+void _simplelog_metrics(void (*callback)(const struct simplelog_metrics * metrics, void * ctx),
+                        void * ctx);
+void _simplelog_site_profiling(int enable, unsigned summary_interval);
+void _simplelog_top_sites(size_t count,
+                          void (*callback)(const struct simplelog_site * site, void * ctx),
+                          void * ctx);
+void _simplelog_stage_timing(unsigned sampling);
+void _simplelog_stage_timings(void (*callback)(const struct simplelog_stage * stage, void * ctx),
+                              void * ctx);
+void _simplelog_load_shedding(unsigned verbose, unsigned debug, unsigned info);
+void _simplelog_crash_handler(int enable);
+void _simplelog_flush_all(void);
 void * _simplelog_create(const char * tag, const char * loggers_names);
+void * _simplelog_create_once(void ** module, const char * tag, const char * loggers_names);
 void _simplelog_log(void * thiz, int prio, const char * filename, const char * funcname, int line,
                     const char * msg, ...) __attribute__((format(printf, 6, 7)));
+void _simplelog_logf(void * thiz, void ** format_cache, int prio, const char * filename,
+                     const char * funcname, int line, const char * msg, ...)
+        __attribute__((format(printf, 7, 8)));
+void _simplelog_log_str(void * thiz, int prio, const char * filename, const char * funcname,
+                        int line, const char * msg, size_t len);
+void _simplelog_logf_site(void * thiz, struct _simplelog_site * site, double per_second,
+                          void ** format_cache, int prio, const char * filename,
+                          const char * funcname, int line, const char * msg, ...)
+        __attribute__((format(printf, 9, 10)));
+void _simplelog_log_str_site(void * thiz, struct _simplelog_site * site, int prio,
+                             const char * filename, const char * funcname, int line,
+                             const char * msg, size_t len);
 void _simplelog_flush(void * thiz);
 
 #ifdef __cplusplus
@@ -399,55 +778,185 @@ void _simplelog_flush(void * thiz);
         _simplelog_register_logger(name, type, 0);                                                 \
     } while (0)
 
-#define _SLOG_DECLARE_MODULE_IMPL(_1, _2, FUNC, ...) FUNC
-#define _SLOG_DECLARE_MODULE_1(tag)                                                                \
-    static void * __simplelog_module__USE__SLOG_DECLARE_MODULE()                                   \
-    {                                                                                              \
-        static void * module = NULL;                                                               \
-        if (module == NULL)                                                                        \
-            module = _simplelog_create(tag, 0);                                                    \
-        return module;                                                                             \
-    }
+// Atomic accesses to module handles, valid in both C and C++
+#if defined(__GNUC__) || defined(__clang__)
+#define _SLOG_LOAD_ACQUIRE(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define _SLOG_STORE_RELEASE(ptr, val) __atomic_store_n(ptr, val, __ATOMIC_RELEASE)
+#else
+#define _SLOG_LOAD_ACQUIRE(ptr) (*(void * volatile *)(ptr))
+#define _SLOG_STORE_RELEASE(ptr, val) (*(void * volatile *)(ptr) = (val))
+#endif
+
+// Formats are only compiled once per call site when they are string literals
+#if defined(__GNUC__) || defined(__clang__)
+#define _SLOG_IS_LITERAL(str) __builtin_constant_p(str)
+#define _SLOG_STRLEN(str) __builtin_strlen(str)
+#define _SLOG_STRCHR(str, c) __builtin_strchr(str, c)
+#else
+#define _SLOG_IS_LITERAL(str) 0
+#define _SLOG_STRLEN(str) strlen(str)
+#define _SLOG_STRCHR(str, c) strchr(str, c)
+#endif
+
+// Select _SLOG_PRIO_NOARGS when a log only has a message, _SLOG_PRIO_ARGS otherwise
+// (up to 62 arguments)
+#define _SLOG_EXPAND(x) x
+#define _SLOG_CAT(a, b) _SLOG_CAT_IMPL(a, b)
+#define _SLOG_CAT_IMPL(a, b) a##b
+#define _SLOG_ARGS_KIND(...)                                                                       \
+    _SLOG_EXPAND(_SLOG_ARGS_KIND_IMPL(__VA_ARGS__, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS,       \
+        ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS,        \
+        ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS,        \
+        ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS,        \
+        ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, ARGS, NOARGS,      \
+        unused))
+#define _SLOG_ARGS_KIND_IMPL(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15,     \
+                             _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28,      \
+                             _29, _30, _31, _32, _33, _34, _35, _36, _37, _38, _39, _40, _41,      \
+                             _42, _43, _44, _45, _46, _47, _48, _49, _50, _51, _52, _53, _54,      \
+                             _55, _56, _57, _58, _59, _60, _61, _62, _63, kind, ...) kind
+#define _SLOG_PRIO(prio, ...)                                                                      \
+    _SLOG_EXPAND(_SLOG_CAT(_SLOG_PRIO_, _SLOG_ARGS_KIND(__VA_ARGS__))(prio, __VA_ARGS__))
+
+#define _SLOG_DECLARE_MODULE_IMPL(_1, _2, _3, _4, FUNC, ...) FUNC
+#define _SLOG_DECLARE_MODULE_1(tag) _SLOG_DECLARE_MODULE_3(tag, 0, LOG_LEVEL)
 #define _SLOG_DECLARE_MODULE_2(tag, loggers_names)                                                 \
+    _SLOG_DECLARE_MODULE_3(tag, loggers_names, LOG_LEVEL)
+#define _SLOG_DECLARE_MODULE_4(tag, loggers_names, unused, max_level)                              \
+    _SLOG_DECLARE_MODULE_3(tag, loggers_names, max_level)
+#define _SLOG_DECLARE_MODULE_3(tag, loggers_names, max_level)                                      \
+    enum { __simplelog_max_level__USE__SLOG_DECLARE_MODULE = (max_level) };                        \
     static void * __simplelog_module__USE__SLOG_DECLARE_MODULE()                                   \
     {                                                                                              \
         static void * module = NULL;                                                               \
-        if (module == NULL)                                                                        \
-            module = _simplelog_create(tag, loggers_names);                                        \
-        return module;                                                                             \
+        void * m = _SLOG_LOAD_ACQUIRE(&module);                                                    \
+        if (m == NULL)                                                                             \
+            m = _simplelog_create_once(&module, tag, loggers_names);                               \
+        return m;                                                                                  \
     }
 
 #ifdef __cplusplus
 
 #include "private/logger.hpp"
-#define _SLOG_PRIO(prio, ...)                                                                      \
+
+// Format strings are checked at build time, and compiled when the C++ standard allows it
+#ifdef LOG_RUNTIME_FORMAT
+#define _SLOG_FORMAT(msg) fmt::runtime(msg)
+#else
+#define _SLOG_FORMAT(msg) FMT_COMPILE(msg)
+#endif
+
+#define _SLOG_PRIO_ARGS(prio, msg, ...)                                                            \
     do {                                                                                           \
-        reinterpret_cast<simplelog::logger *>(__simplelog_module__USE__SLOG_DECLARE_MODULE())      \
-                ->log(simplelog::log_level(prio), __FILE__, __func__, __LINE__, __VA_ARGS__);      \
+        if ((prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {                           \
+            static struct _simplelog_site _slog_site;                                              \
+            reinterpret_cast<simplelog::module *>(__simplelog_module__USE__SLOG_DECLARE_MODULE())  \
+                    ->log(_slog_site, simplelog::log_level(prio), __FILE__, __func__, __LINE__,    \
+                          _SLOG_FORMAT(msg), __VA_ARGS__);                                         \
+        }                                                                                          \
+    } while (0)
+
+#ifdef LOG_RUNTIME_FORMAT
+#define _SLOG_PRIO_NOARGS(prio, msg)                                                               \
+    do {                                                                                           \
+        if ((prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {                           \
+            static struct _simplelog_site _slog_site;                                              \
+            reinterpret_cast<simplelog::module *>(__simplelog_module__USE__SLOG_DECLARE_MODULE())  \
+                    ->log(_slog_site, simplelog::log_level(prio), __FILE__, __func__, __LINE__,    \
+                          _SLOG_FORMAT(msg));                                                      \
+        }                                                                                          \
+    } while (0)
+#else
+// Messages without arguments nor braces to unescape are written as is
+#define _SLOG_PRIO_NOARGS(prio, msg)                                                               \
+    do {                                                                                           \
+        if ((prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {                           \
+            static struct _simplelog_site _slog_site;                                              \
+            constexpr simplelog::literal literal(msg);                                             \
+            auto m = reinterpret_cast<simplelog::module *>(                                        \
+                    __simplelog_module__USE__SLOG_DECLARE_MODULE());                               \
+            if (literal.plain())                                                                   \
+                m->log(_slog_site, simplelog::log_level(prio), __FILE__, __func__, __LINE__,       \
+                       literal);                                                                   \
+            else                                                                                   \
+                m->log(_slog_site, simplelog::log_level(prio), __FILE__, __func__, __LINE__,       \
+                       _SLOG_FORMAT(msg));                                                         \
+        }                                                                                          \
+    } while (0)
+#endif
+
+#define _SLOG_RATE_LIMIT(prio, per_second, msg, ...)                                               \
+    do {                                                                                           \
+        if ((prio) <= LOG_LEVEL && (prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {    \
+            static struct _simplelog_site _slog_site;                                              \
+            static const simplelog::rate_limit _slog_limit(per_second, 1);                         \
+            reinterpret_cast<simplelog::module *>(__simplelog_module__USE__SLOG_DECLARE_MODULE())  \
+                    ->logLimited(_slog_site, _slog_limit, simplelog::log_level(prio), __FILE__,    \
+                                 __func__, __LINE__, _SLOG_FORMAT(msg), ##__VA_ARGS__);            \
+        }                                                                                          \
     } while (0)
 
 #else // __cplusplus
 
-#define _SLOG_PRIO(prio, ...)                                                                      \
+#define _SLOG_PRIO_ARGS(prio, msg, ...)                                                            \
+    do {                                                                                           \
+        if ((prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {                           \
+            static void * format = NULL;                                                           \
+            static struct _simplelog_site _slog_site;                                              \
+            _simplelog_logf_site(__simplelog_module__USE__SLOG_DECLARE_MODULE(), &_slog_site, -1,  \
+                                 _SLOG_IS_LITERAL(msg) ? &format : NULL, prio, __FILE__, __func__, \
+                                 __LINE__, msg, __VA_ARGS__);                                      \
+        }                                                                                          \
+    } while (0)
+
+// Literal messages without arguments nor '%' to unescape are written as is
+#define _SLOG_PRIO_NOARGS(prio, msg)                                                               \
     do {                                                                                           \
-        _simplelog_log(__simplelog_module__USE__SLOG_DECLARE_MODULE(), prio, __FILE__, __func__,   \
-                       __LINE__, __VA_ARGS__);                                                     \
+        if ((prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {                           \
+            static struct _simplelog_site _slog_site;                                              \
+            if (_SLOG_IS_LITERAL(msg) && !_SLOG_STRCHR(msg, '%'))                                  \
+                _simplelog_log_str_site(__simplelog_module__USE__SLOG_DECLARE_MODULE(),            \
+                                        &_slog_site, prio, __FILE__, __func__, __LINE__, msg,      \
+                                        _SLOG_STRLEN(msg));                                        \
+            else {                                                                                 \
+                static void * format = NULL;                                                       \
+                _simplelog_logf_site(__simplelog_module__USE__SLOG_DECLARE_MODULE(), &_slog_site,  \
+                                     -1, _SLOG_IS_LITERAL(msg) ? &format : NULL, prio, __FILE__,   \
+                                     __func__, __LINE__, msg);                                     \
+            }                                                                                      \
+        }                                                                                          \
+    } while (0)
+
+#define _SLOG_RATE_LIMIT(prio, per_second, msg, ...)                                               \
+    do {                                                                                           \
+        if ((prio) <= LOG_LEVEL && (prio) <= __simplelog_max_level__USE__SLOG_DECLARE_MODULE) {    \
+            static void * format = NULL;                                                           \
+            static struct _simplelog_site _slog_site;                                              \
+            _simplelog_logf_site(__simplelog_module__USE__SLOG_DECLARE_MODULE(), &_slog_site,      \
+                                 per_second, _SLOG_IS_LITERAL(msg) ? &format : NULL, prio,         \
+                                 __FILE__, __func__, __LINE__, msg, ##__VA_ARGS__);                \
+        }                                                                                          \
     } while (0)
 
 #endif // __cplusplus
 
+// Flush all engines before aborting, as logs of other tags may explain the failure. Logs of the
+// crash handler, if installed, are then written after them.
 #define _LOG_FLUSH()                                                                               \
     do {                                                                                           \
-        _simplelog_flush(__simplelog_module__USE__SLOG_DECLARE_MODULE());                          \
+        _simplelog_flush_all();                                                                    \
     } while (0)
 
 #ifdef LOG_ASSERT_ENABLED
 
 #ifdef __cplusplus
+// The condition is the first argument rather than a part of the format, as it may hold braces
+#define _SLOG_ASSERT_PRIO(prio, condition, msg, ...)                                               \
+    _SLOG_PRIO(prio, "Assert failed: {}: " msg, condition, ##__VA_ARGS__)
 #define _SLOG_GENERIC_ASSERT(type, assert, condition, ...)                                         \
     do {                                                                                           \
         if (!(assert)) {                                                                           \
-            _SLOG_PRIO(LOG_LEVEL_PANIC, "Assert failed: " condition ": " __VA_ARGS__);             \
+            _SLOG_ASSERT_PRIO(LOG_LEVEL_PANIC, condition, "" __VA_ARGS__);                         \
             _SLOG_PRIO(LOG_LEVEL_PANIC, "file \"{}\" function \"{}\" line {}", __FILE__, __func__, \
                        __LINE__);                                                                  \
             if (type == SLOG_ASSERT_TYPE_ABORT) {                                                  \
@@ -457,10 +966,13 @@ void _simplelog_flush(void * thiz);
         }                                                                                          \
     } while (0)
 #else
+// The condition is the first argument rather than a part of the format, as it may hold '%'
+#define _SLOG_ASSERT_PRIO(prio, condition, msg, ...)                                               \
+    _SLOG_PRIO(prio, "Assert failed: %s: " msg, condition, ##__VA_ARGS__)
 #define _SLOG_GENERIC_ASSERT(type, assert, condition, ...)                                         \
     do {                                                                                           \
         if (!(assert)) {                                                                           \
-            _SLOG_PRIO(LOG_LEVEL_PANIC, "Assert failed: " condition ": " __VA_ARGS__);             \
+            _SLOG_ASSERT_PRIO(LOG_LEVEL_PANIC, condition, "" __VA_ARGS__);                         \
             _SLOG_PRIO(LOG_LEVEL_PANIC, "file \"%s\" function \"%s\" line %d", __FILE__, __func__, \
                        __LINE__);                                                                  \
             if (type == SLOG_ASSERT_TYPE_ABORT) {                                                  \
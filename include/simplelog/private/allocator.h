@@ -0,0 +1,97 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_ALLOCATOR_H
+#define SIMPLELOG_ALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace simplelog {
+
+class memory
+{
+public:
+    // Size of the real-time pool blocks, and of its largest allocations
+    static const size_t blockSize = 64 * 1024;
+
+    // Allocate through user hooks, or from the real-time pool once enabled.
+    // Abort if the allocation can't be served.
+    static void * allocate(size_t size);
+    // Same as allocate, but return nullptr instead of aborting
+    static void * tryAllocate(size_t size);
+    static void release(void * ptr);
+
+    // Construct and destroy objects with allocate and release
+    template<typename T, typename... Args>
+    static T * create(Args &&... args)
+    {
+        return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+    template<typename T>
+    static void destroy(T * ptr)
+    {
+        if (!ptr)
+            return;
+        ptr->~T();
+        release(ptr);
+    }
+};
+
+// Deleter of the objects created by memory::create, for std::unique_ptr
+struct memory_deleter
+{
+    template<typename T>
+    void operator()(T * ptr) const
+    {
+        memory::destroy(ptr);
+    }
+};
+
+// STL allocator routing simplelog internal allocations through simplelog::memory.
+// A Fallible allocator throws std::bad_alloc instead of aborting, for callers able to do
+// without the memory.
+template<typename T, bool Fallible = false>
+class allocator
+{
+public:
+    using value_type = T;
+    template<typename U>
+    struct rebind
+    {
+        using other = allocator<U, Fallible>;
+    };
+
+    allocator() = default;
+    template<typename U>
+    allocator(const allocator<U, Fallible> &)
+    {}
+
+    T * allocate(size_t n)
+    {
+        if (!Fallible)
+            return static_cast<T *>(memory::allocate(n * sizeof(T)));
+        void * ptr = memory::tryAllocate(n * sizeof(T));
+        if (!ptr)
+            throw std::bad_alloc();
+        return static_cast<T *>(ptr);
+    }
+    void deallocate(T * ptr, size_t) { memory::release(ptr); }
+
+    template<typename U>
+    bool operator==(const allocator<U, Fallible> &) const
+    {
+        return true;
+    }
+    template<typename U>
+    bool operator!=(const allocator<U, Fallible> &) const
+    {
+        return false;
+    }
+};
+
+} // namespace simplelog
+
+#endif
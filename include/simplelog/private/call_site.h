@@ -0,0 +1,84 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_CALL_SITE_H
+#define SIMPLELOG_CALL_SITE_H
+
+#include <cstdarg>
+#include <cstdint>
+
+#include "formatter.h"
+
+struct _simplelog_site;
+
+namespace simplelog {
+
+class module;
+
+// Token bucket of a call site: up to count logs at once, then count logs per period.
+// A limit without interval doesn't drop logs, and only folds duplicates.
+struct rate_limit
+{
+    int64_t intervalNs;
+    int64_t toleranceNs;
+
+    constexpr rate_limit() : intervalNs(0), toleranceNs(0) {}
+    constexpr rate_limit(double count, double seconds) :
+        intervalNs(count > 0 ? static_cast<int64_t>(seconds * 1e9 / count) : 0),
+        toleranceNs(count >= 2 ? static_cast<int64_t>((static_cast<int64_t>(count) - 1)
+                                                      * (seconds * 1e9 / count))
+                               : 0)
+    {}
+};
+
+// A call site with folded or dropped logs not reported yet, and how to report them
+struct pending_site
+{
+    _simplelog_site * site;
+    module * owner;
+    log_level level;
+    const char * filename;
+    const char * funcname;
+    int line;
+};
+
+// Rate limiting and duplicates folding of a call site, through its _simplelog_site state.
+// The state is only updated with atomic operations, as a site may log from several threads.
+class call_site
+{
+public:
+    // Whether a log of the site is within its rate limit, counting it as dropped otherwise.
+    // Called before any formatting.
+    static bool admit(_simplelog_site & site, const rate_limit & limit);
+
+    // Whether a formatted message should be written: the same message as the previous one of the
+    // site is folded, unless the previous one was written more than a second ago.
+    // When it should be written, repeats is the count of folded duplicates of the previous message
+    // and dropped the count of logs dropped by the rate limit, since the previous write.
+    static bool unfold(_simplelog_site & site, string_view msg, uint64_t & repeats,
+                       uint64_t & dropped);
+
+    // Report the folded and dropped logs of a site even if it doesn't log again: once its folding
+    // window expired, or at the latest a second later for dropped logs. Called after a log of the
+    // site was folded or dropped.
+    static void defer(const pending_site & pending);
+
+    // Report the folded and dropped logs of all sites now, ie. on flush
+    static void reportPending();
+
+#ifndef _WIN32
+    static void prepareFork();
+    static void parentFork();
+    static void childFork();
+#endif
+
+    // Render a printf-style message
+    static void render(memory_buffer & buffer, const char * msg, va_list args);
+
+    static const int64_t foldWindowNs = 1000000000;
+};
+
+} // namespace simplelog
+
+#endif
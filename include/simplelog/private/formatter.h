@@ -5,72 +5,136 @@
 #ifndef SIMPLELOG_FORMATTER
 #define SIMPLELOG_FORMATTER
 
+#include <cstdarg>
+#include <cstdio>
 #include <fmt/format.h>
-#include <math.h>
 #include <memory>
-#include <mutex>
 #include <string>
 #include <type_traits>
 
+#include "allocator.h"
 #include "casecmp.h"
 #include "log_metadata.h"
+#include "render.h"
 
 namespace simplelog {
 
-using memory_buffer = fmt::basic_memory_buffer<char, LOG_MAX_LINE_LENGTH>;
+using memory_buffer = fmt::basic_memory_buffer<char, LOG_MAX_LINE_LENGTH, allocator<char>>;
 using string_view = fmt::basic_string_view<char>;
 
+// Formatting buffers reused by all the logs of a thread, so that long lines only allocate
+// the first time they are seen. Logs emitted while a buffer is in use (from a logger)
+// get their own buffer.
+class thread_buffer
+{
+public:
+    enum slot
+    {
+        message, // User message, before being formatted
+        line,    // Full formatted line
+        slots
+    };
+
+    thread_buffer(slot s) : m_slot(s), m_owner(!inUse()[s])
+    {
+        if (m_owner) {
+            inUse()[s] = true;
+            shared()[s].clear();
+        } else {
+            m_nested.reset(memory::create<memory_buffer>());
+        }
+    }
+    ~thread_buffer()
+    {
+        if (!m_owner)
+            return;
+        // Don't keep exceptionally long lines around for the whole thread lifetime
+        if (shared()[m_slot].capacity() > m_maxRetainedSize)
+            shared()[m_slot] = memory_buffer();
+        inUse()[m_slot] = false;
+    }
+    thread_buffer(const thread_buffer &) = delete;
+    thread_buffer & operator=(const thread_buffer &) = delete;
+
+    memory_buffer & get() { return m_owner ? shared()[m_slot] : *m_nested; }
+
+private:
+    static memory_buffer * shared()
+    {
+        static thread_local memory_buffer buffers[slots];
+        return buffers;
+    }
+    static bool * inUse()
+    {
+        static thread_local bool used[slots] = {};
+        return used;
+    }
+
+    static const size_t m_maxRetainedSize = 64 * 1024;
+    const slot m_slot;
+    const bool m_owner;
+    std::unique_ptr<memory_buffer, memory_deleter> m_nested;
+};
+
 class iformatter
 {
 public:
-    iformatter() :
-        m_year(0), m_month(0), m_day(0), m_hour(0), m_minute(0), m_second(0), m_millisecond(0)
-    {}
     virtual ~iformatter() = default;
-    virtual void format(std::mutex & mutex, const log_metadata & metadata,
-                        memory_buffer & formatted, const char * msg, va_list args) = 0;
-    virtual void format(std::mutex & mutex, const log_metadata & metadata, string_view msg,
+    // Formatters may be called concurrently from several threads
+    virtual void format(const log_metadata & metadata, memory_buffer & formatted, const char * msg,
+                        va_list args) = 0;
+    virtual void format(const log_metadata & metadata, string_view msg,
                         memory_buffer & formatted) = 0;
 
 protected:
+    // Date and time last rendered, to be kept per thread by formatters caching their prefixes
+    struct rendered_time
+    {
+        long long epoch = -1;
+        timestamp_mode mode = timestamp_mode::local;
+        int millisecond = -1;
+    };
+
     template<typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
     void appendDecimal(memory_buffer & buffer, T decimal, int padding = -1)
     {
-        fmt::format_int i(decimal);
-        for (int i = padding - 1; i > 0 && decimal < pow(10, i); i--)
-            buffer.push_back('0');
-        buffer.append(i.data(), i.data() + i.size());
+        render::decimal(buffer, decimal, padding);
+    }
+    // Append a printf-style message, growing the buffer as needed so that nothing is truncated
+    void appendPrintf(memory_buffer & buffer, const char * msg, va_list args)
+    {
+        const size_t size = buffer.size();
+        va_list copy;
+        va_copy(copy, args);
+        int len = vsnprintf(buffer.data() + size, buffer.capacity() - size, msg, copy);
+        va_end(copy);
+        if (len < 0)
+            return;
+        if (size + len >= buffer.capacity()) {
+            buffer.reserve(size + len + 1);
+            vsnprintf(buffer.data() + size, len + 1, msg, args);
+        }
+        buffer.resize(size + len);
     }
     void append(memory_buffer & buffer, memory_buffer & str)
     {
-        string_view view(str.data());
-        buffer.append(view.data(), view.data() + view.size());
+        buffer.append(str.data(), str.data() + str.size());
     }
-    bool shouldUpdateSeconds(const log_metadata & metadata)
+    bool shouldUpdateSeconds(rendered_time & last, const log_metadata & metadata)
     {
-        if (metadata.hour == m_hour && metadata.minute == m_minute && metadata.second == m_second)
+        if (metadata.epoch == last.epoch && metadata.timestamp == last.mode)
             return false;
-        m_hour = metadata.hour;
-        m_minute = metadata.minute;
-        m_second = metadata.second;
+        last.epoch = metadata.epoch;
+        last.mode = metadata.timestamp;
         return true;
     }
-    bool shouldUpdateMilliseconds(const log_metadata & metadata)
+    bool shouldUpdateMilliseconds(rendered_time & last, const log_metadata & metadata)
     {
-        if (metadata.millisecond == m_millisecond)
+        if (metadata.millisecond == last.millisecond)
             return false;
-        m_millisecond = metadata.millisecond;
+        last.millisecond = metadata.millisecond;
         return true;
     }
-
-private:
-    int m_year;
-    int m_month;
-    int m_day;
-    int m_hour;
-    int m_minute;
-    int m_second;
-    int m_millisecond;
 };
 
 class formatter_factory
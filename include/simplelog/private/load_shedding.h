@@ -0,0 +1,48 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_LOAD_SHEDDING_H
+#define SIMPLELOG_LOAD_SHEDDING_H
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "log_metadata.h"
+
+namespace simplelog {
+
+// Adaptive level of asynchronous engines: above watermarks of the asynchronous queue fill,
+// verbose, then debug, then info logs are dropped before being formatted, rather than random
+// logs once the queue is full. Levels are restored as the queue drains.
+class load_shedding
+{
+public:
+    static const size_t maxSteps = 3;
+
+    // Queue fill percentages from which verbose, debug, then info logs are dropped, empty to
+    // disable shedding
+    static void setWatermarks(const std::vector<unsigned> & percents);
+
+    // Whether watermarks are set
+    static bool enabled() { return m_watermarks[0].load(std::memory_order_relaxed) != 0; }
+
+    // Most verbose level kept by asynchronous engines
+    static log_level level()
+    {
+        return static_cast<log_level>(m_level.load(std::memory_order_relaxed));
+    }
+
+    // Update the level from the count of queued records, and return whether it changed.
+    // Called by the asynchronous backend, with its queue locked.
+    static bool update(size_t queued, size_t maxQueued);
+
+private:
+    static std::atomic<int> m_level;
+    static std::atomic<unsigned> m_watermarks[maxSteps];
+};
+
+} // namespace simplelog
+
+#endif
@@ -5,6 +5,8 @@
 #ifndef SIMPLELOG_LOGMETADATA_H
 #define SIMPLELOG_LOGMETADATA_H
 
+#include <cstddef>
+
 namespace simplelog {
 
 // Should match with LOG_LEVEL_* from logger.h
@@ -17,6 +19,20 @@ enum log_level : int {
     panic = 1,
 };
 
+// Clock used for logs timestamps
+enum class timestamp_mode : int {
+    local, // Local date and time
+    utc,   // UTC date and time
+    epoch, // Seconds since the Unix epoch
+};
+
+// Resolution of logs timestamps
+enum class timestamp_precision : int {
+    ms,
+    us,
+    ns,
+};
+
 struct log_metadata
 {
     const char * tag;
@@ -33,6 +49,11 @@ struct log_metadata
     int minute;
     int second;
     int millisecond;
+
+    int nanosecond;  // Within the second, millisecond included
+    long long epoch; // Seconds since the Unix epoch, whatever the mode
+    timestamp_mode timestamp;
+    timestamp_precision precision;
 };
 
 } // namespace simplelog
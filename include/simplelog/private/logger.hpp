@@ -8,18 +8,53 @@
 #include <chrono>
 #include <cstdarg>
 #include <cstring>
+#include <ctime>
+#include <fmt/compile.h>
 #include <fmt/format.h>
 #include <mutex>
 #include <thread>
 #include <vector>
 
+#include "call_site.h"
 #include "casecmp.h"
 #include "formatter.h"
+#include "load_shedding.h"
 #include "log_metadata.h"
+#include "metrics.h"
 #include "os.h"
+#include "printf_format.h"
+#include "sampler.h"
+#include "site_profiler.h"
+#include "stage_timing.h"
 
 namespace simplelog {
 
+// Log message without arguments, known at build time
+class literal
+{
+public:
+    template<size_t N>
+    constexpr literal(const char (&msg)[N]) : m_msg(msg, N - 1), m_plain(isPlain(msg, N - 1))
+    {}
+
+    constexpr string_view view() const { return m_msg; }
+    // Whether the message can be written as is, without braces to unescape
+    constexpr bool plain() const { return m_plain; }
+
+private:
+    static constexpr bool isPlain(const char * msg, size_t len)
+    {
+        for (size_t i = 0; i < len; i++) {
+            if (msg[i] == '{' || msg[i] == '}')
+                return false;
+        }
+        return true;
+    }
+
+    const string_view m_msg;
+    const bool m_plain;
+};
+
 class logger
 {
 public:
@@ -27,19 +62,37 @@ public:
     logger(const std::string & tag, log_level level, const std::shared_ptr<iformatter> & f) :
         m_tag(tag),
         m_level(level),
-        m_formatter(f),
-        m_year(0),
-        m_month(0),
-        m_day(0),
-        m_hour(0),
-        m_minute(0),
-        m_second(0),
-        m_millisecond(0)
+        m_formatter(f)
     {}
     virtual ~logger() = default;
 
     virtual void flush() {}
     virtual void logRaw(log_level level, const char * msg, size_t len) = 0;
+    // File descriptor written by the crash handler, -1 if the logger can't be written from a
+    // signal handler
+    virtual int crashFd() const { return -1; }
+    // Write the data buffered by the logger to crashFd(), from a signal handler
+    virtual void crashFlush() {}
+    // Called in the child process after a fork, while nothing is logging
+    virtual void afterFork() {}
+
+    // Write a formatted line, or flush, as a sink of an engine, accounting for it in the sink
+    // metrics. They may be called concurrently by engines sharing this logger.
+    void writeRaw(log_level level, const char * msg, size_t len);
+    void flushRaw();
+    // Hold off the writes of this logger across a fork, so that none is in progress
+    void lockWrites() { m_mutexlogger.lock(); }
+    void unlockWrites() { m_mutexlogger.unlock(); }
+    const sink_metrics & sinkMetrics() const { return m_sinkMetrics; }
+    // Whether logs are queued to the asynchronous backend, and subject to its load shedding
+    bool async() const { return m_async; }
+
+    // Clock and resolution of the timestamps of the logs formatted by this logger
+    void setTimestamp(timestamp_mode mode, timestamp_precision precision)
+    {
+        m_timestampMode = mode;
+        m_timestampPrecision = precision;
+    }
 
     template<typename... Args>
     void log(log_level level, const char * filename, const char * funcname, int line,
@@ -47,14 +100,8 @@ public:
     {
         if (level > m_level)
             return;
-        memory_buffer buf;
-        format_to(buf, msg, std::forward<Args>(args)...);
-        memory_buffer formatted;
-        m_formatter->format(m_mutexFormat, getMetadata(level, filename, funcname, line),
-                            string_view(buf.begin(), buf.size()), formatted);
-        formatted.append(os::getEol(), os::getEol() + strlen(os::getEol()));
-        std::lock_guard<std::mutex> lock(m_mutexlogger);
-        logRaw(level, formatted.begin(), formatted.size());
+        write(m_tag.c_str(), level, filename, funcname, line, fmt::runtime(msg),
+              std::forward<Args>(args)...);
     }
 
     void log(log_level level, const char * filename, const char * funcname, int line,
@@ -62,68 +109,361 @@ public:
     {
         if (level > m_level)
             return;
-        memory_buffer formatted;
-        m_formatter->format(m_mutexFormat, getMetadata(level, filename, funcname, line), formatted,
-                            msg, args);
+        write(m_tag.c_str(), level, filename, funcname, line, msg, args);
+    }
+
+    // Format and write a log on behalf of tag, without any level filtering.
+    // format is either a runtime format, or a format checked (and compiled if possible) at build
+    // time by FMT_COMPILE.
+    template<typename S, typename... Args>
+    void write(const char * tag, log_level level, const char * filename, const char * funcname,
+               int line, const S & format, Args &&... args)
+    {
+        stage_timer timer;
+        thread_buffer buffer(thread_buffer::message);
+        memory_buffer & buf = buffer.get();
+        fmt::format_to(fmt::appender(buf), format, std::forward<Args>(args)...);
+        timer.lap(stage::message);
+        writeLine(tag, level, filename, funcname, line, string_view(buf.data(), buf.size()), timer);
+    }
+
+    void write(const char * tag, log_level level, const char * filename, const char * funcname,
+               int line, const printf_format & format, va_list args)
+    {
+        stage_timer timer;
+        thread_buffer buffer(thread_buffer::message);
+        memory_buffer & buf = buffer.get();
+        format.render(buf, args);
+        timer.lap(stage::message);
+        writeLine(tag, level, filename, funcname, line, string_view(buf.data(), buf.size()), timer);
+    }
+
+    void write(const char * tag, log_level level, const char * filename, const char * funcname,
+               int line, const char * msg, va_list args)
+    {
+        stage_timer timer;
+        thread_buffer buffer(thread_buffer::line);
+        memory_buffer & formatted = buffer.get();
+        m_formatter->format(getMetadata(tag, level, filename, funcname, line), formatted, msg,
+                            args);
         formatted.append(os::getEol(), os::getEol() + strlen(os::getEol()));
+        if (site_profiler::enabled())
+            site_profiler::record(tag, level, filename, line, formatted.size());
+        timer.lap(stage::line);
         std::lock_guard<std::mutex> lock(m_mutexlogger);
+        timer.lap(stage::lock);
         logRaw(level, formatted.begin(), formatted.size());
+        timer.lap(stage::consume);
     }
 
+    // Write an already formatted user message
+    void writeFormatted(const char * tag, log_level level, const char * filename,
+                        const char * funcname, int line, string_view msg)
+    {
+        stage_timer timer;
+        writeLine(tag, level, filename, funcname, line, msg, timer);
+    }
+
+    // Write a user message formatted while timed by timer
+    void writeFormatted(const char * tag, log_level level, const char * filename,
+                        const char * funcname, int line, string_view msg, stage_timer & timer)
+    {
+        writeLine(tag, level, filename, funcname, line, msg, timer);
+    }
+
+protected:
+    bool m_async = false;
+
 private:
-    log_metadata getMetadata(log_level level, const char * filename, const char * funcname, int line)
+    void writeLine(const char * tag, log_level level, const char * filename, const char * funcname,
+                   int line, string_view msg, stage_timer & timer)
+    {
+        thread_buffer buffer(thread_buffer::line);
+        memory_buffer & formatted = buffer.get();
+        m_formatter->format(getMetadata(tag, level, filename, funcname, line), msg, formatted);
+        formatted.append(os::getEol(), os::getEol() + strlen(os::getEol()));
+        if (site_profiler::enabled())
+            site_profiler::record(tag, level, filename, line, formatted.size());
+        timer.lap(stage::line);
+        std::lock_guard<std::mutex> lock(m_mutexlogger);
+        timer.lap(stage::lock);
+        logRaw(level, formatted.begin(), formatted.size());
+        timer.lap(stage::consume);
+    }
+
+    // Date and time of the last log of a thread, only converted again when the second changes
+    struct timestamp
+    {
+        long long epoch = -1;
+        int year = 0;
+        int month = 0;
+        int day = 0;
+        int hour = 0;
+        int minute = 0;
+        int second = 0;
+    };
+
+    log_metadata getMetadata(const char * tag, log_level level, const char * filename,
+                             const char * funcname, int line) const
     {
-        updateTimestamp();
-        return log_metadata{ m_tag.c_str(), level,    os::getThreadId(), filename, funcname,
-                             line,          m_year,   m_month,           m_day,    m_hour,
-                             m_minute,      m_second, m_millisecond };
+        using namespace std::chrono;
+        const long long ns =
+                duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+        const long long secs = ns / 1000000000;
+        const int nanosecond = static_cast<int>(ns % 1000000000);
+        const timestamp & t = updateTimestamp(m_timestampMode, secs);
+        return log_metadata{ tag,
+                             level,
+                             os::getThreadId(),
+                             filename,
+                             funcname,
+                             line,
+                             t.year,
+                             t.month,
+                             t.day,
+                             t.hour,
+                             t.minute,
+                             t.second,
+                             nanosecond / 1000000,
+                             nanosecond,
+                             secs,
+                             m_timestampMode,
+                             m_timestampPrecision };
     }
 
-    void updateTimestamp()
+    static const timestamp & updateTimestamp(timestamp_mode mode, long long secs)
     {
-        // Use a cache on seconds and milliseconds levels to improve efficiency
-        auto now = std::chrono::system_clock::now();
-        if (now != m_lastTimestamp) {
-            using namespace std::chrono;
-            seconds secs = duration_cast<seconds>(now.time_since_epoch());
-            if (m_lastSeconds != secs) {
-                time_t tt = system_clock::to_time_t(now);
-                tm timestamp;
+        // One cache per mode, as loggers of a thread may use different modes
+        static thread_local timestamp cache[3];
+        timestamp & t = cache[static_cast<int>(mode)];
+        if (t.epoch == secs)
+            return t;
+        t.epoch = secs;
+        if (mode == timestamp_mode::local) {
+            time_t tt = static_cast<time_t>(secs);
+            tm local;
 #if defined(_WIN32)
-                localtime_s(&timestamp, &tt);
+            localtime_s(&local, &tt);
 #else
-                localtime_r(&tt, &timestamp);
+            localtime_r(&tt, &local);
 #endif
-                m_lastSeconds = secs;
-                m_year = timestamp.tm_year + 1900;
-                m_month = timestamp.tm_mon + 1;
-                m_day = timestamp.tm_mday;
-                m_hour = timestamp.tm_hour;
-                m_minute = timestamp.tm_min;
-                m_second = timestamp.tm_sec;
-            }
-            m_lastTimestamp = now;
-            milliseconds ms = duration_cast<milliseconds>(now.time_since_epoch());
-            m_millisecond = ms.count() % 1000;
+            t.year = local.tm_year + 1900;
+            t.month = local.tm_mon + 1;
+            t.day = local.tm_mday;
+            t.hour = local.tm_hour;
+            t.minute = local.tm_min;
+            t.second = local.tm_sec;
+        } else if (mode == timestamp_mode::utc) {
+            toUtc(secs, t);
         }
+        return t;
+    }
+
+    // Civil UTC date of a Unix time, without going through the C library and its timezone lock
+    // (http://howardhinnant.github.io/date_algorithms.html#civil_from_days)
+    static void toUtc(long long secs, timestamp & t)
+    {
+        long long days = secs / 86400;
+        long long rem = secs % 86400;
+        if (rem < 0) {
+            rem += 86400;
+            days--;
+        }
+        t.hour = static_cast<int>(rem / 3600);
+        t.minute = static_cast<int>(rem % 3600 / 60);
+        t.second = static_cast<int>(rem % 60);
+
+        days += 719468;
+        const long long era = (days >= 0 ? days : days - 146096) / 146097;
+        const unsigned doe = static_cast<unsigned>(days - era * 146097);
+        const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+        const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+        const unsigned mp = (5 * doy + 2) / 153;
+        t.day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+        t.month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+        t.year = static_cast<int>(yoe + era * 400 + (t.month <= 2));
     }
 
     const std::string m_tag;
     log_level m_level;
     std::shared_ptr<iformatter> m_formatter;
-    std::chrono::system_clock::time_point m_lastTimestamp;
-    std::chrono::seconds m_lastSeconds;
-    int m_year;
-    int m_month;
-    int m_day;
-    int m_hour;
-    int m_minute;
-    int m_second;
-    int m_millisecond;
-    std::mutex m_mutexFormat;
+    timestamp_mode m_timestampMode = timestamp_mode::local;
+    timestamp_precision m_timestampPrecision = timestamp_precision::ms;
+    sink_metrics m_sinkMetrics;
     std::mutex m_mutexlogger;
 };
 
+// Handle of a declared module.
+// Modules sharing the same routing (level, loggers, formatter) share the same engine.
+class module
+{
+public:
+    module(const std::string & tag, log_level level, const std::shared_ptr<logger> & engine,
+           const rate_limit * limit = nullptr, const sample_rates * samples = nullptr) :
+        m_tag(tag),
+        m_level(level),
+        m_engine(engine),
+        m_limited(limit != nullptr),
+        m_limit(limit ? *limit : rate_limit()),
+        m_sampler(samples && sampler::any(*samples) ? memory::create<sampler>(*samples) : nullptr)
+    {}
+
+    template<typename S, typename... Args>
+    void log(log_level level, const char * filename, const char * funcname, int line,
+             const S & format, Args &&... args)
+    {
+        if (filtered(level))
+            return;
+        m_engine->write(m_tag.c_str(), level, filename, funcname, line, format,
+                        std::forward<Args>(args)...);
+    }
+
+    void log(log_level level, const char * filename, const char * funcname, int line,
+             const char * msg, va_list args)
+    {
+        if (filtered(level))
+            return;
+        m_engine->write(m_tag.c_str(), level, filename, funcname, line, msg, args);
+    }
+
+    void log(log_level level, const char * filename, const char * funcname, int line,
+             const printf_format & format, va_list args)
+    {
+        if (filtered(level))
+            return;
+        m_engine->write(m_tag.c_str(), level, filename, funcname, line, format, args);
+    }
+
+    void log(log_level level, const char * filename, const char * funcname, int line,
+             const literal & msg)
+    {
+        logFormatted(level, filename, funcname, line, msg.view());
+    }
+
+    // Log a message written as is
+    void logFormatted(log_level level, const char * filename, const char * funcname, int line,
+                      string_view msg)
+    {
+        if (filtered(level))
+            return;
+        m_engine->writeFormatted(m_tag.c_str(), level, filename, funcname, line, msg);
+    }
+
+    // Log from a call site, subject to the rate limit and sampling of the module tag if any
+    template<typename S, typename... Args>
+    void log(_simplelog_site & site, log_level level, const char * filename, const char * funcname,
+             int line, const S & format, Args &&... args)
+    {
+        if (!m_limited && !m_sampler)
+            return log(level, filename, funcname, line, format, std::forward<Args>(args)...);
+        logSite(site, m_limited ? &m_limit : nullptr, level, filename, funcname, line,
+                [&](memory_buffer & buf) { fmt::format_to(fmt::appender(buf), format, args...); });
+    }
+
+    void log(_simplelog_site & site, log_level level, const char * filename, const char * funcname,
+             int line, const char * msg, va_list args)
+    {
+        if (!m_limited && !m_sampler)
+            return log(level, filename, funcname, line, msg, args);
+        logSite(site, m_limited ? &m_limit : nullptr, level, filename, funcname, line,
+                [&](memory_buffer & buf) { call_site::render(buf, msg, args); });
+    }
+
+    void log(_simplelog_site & site, log_level level, const char * filename, const char * funcname,
+             int line, const printf_format & format, va_list args)
+    {
+        if (!m_limited && !m_sampler)
+            return log(level, filename, funcname, line, format, args);
+        logSite(site, m_limited ? &m_limit : nullptr, level, filename, funcname, line,
+                [&](memory_buffer & buf) { format.render(buf, args); });
+    }
+
+    void log(_simplelog_site & site, log_level level, const char * filename, const char * funcname,
+             int line, const literal & msg)
+    {
+        logFormatted(site, level, filename, funcname, line, msg.view());
+    }
+
+    void logFormatted(_simplelog_site & site, log_level level, const char * filename,
+                      const char * funcname, int line, string_view msg)
+    {
+        if (!m_limited && !m_sampler)
+            return logFormatted(level, filename, funcname, line, msg);
+        logSite(site, m_limited ? &m_limit : nullptr, level, filename, funcname, line,
+                [&](memory_buffer & buf) { buf.append(msg.begin(), msg.end()); });
+    }
+
+    // Log from a call site, subject to the given rate limit
+    template<typename S, typename... Args>
+    void logLimited(_simplelog_site & site, const rate_limit & limit, log_level level,
+                    const char * filename, const char * funcname, int line, const S & format,
+                    Args &&... args)
+    {
+        logSite(site, &limit, level, filename, funcname, line,
+                [&](memory_buffer & buf) { fmt::format_to(fmt::appender(buf), format, args...); });
+    }
+
+    void logLimited(_simplelog_site & site, const rate_limit & limit, log_level level,
+                    const char * filename, const char * funcname, int line, const char * msg,
+                    va_list args)
+    {
+        logSite(site, &limit, level, filename, funcname, line,
+                [&](memory_buffer & buf) { call_site::render(buf, msg, args); });
+    }
+
+    void logLimited(_simplelog_site & site, const rate_limit & limit, log_level level,
+                    const char * filename, const char * funcname, int line,
+                    const printf_format & format, va_list args)
+    {
+        logSite(site, &limit, level, filename, funcname, line,
+                [&](memory_buffer & buf) { format.render(buf, args); });
+    }
+
+    void flush() { m_engine->flush(); }
+
+    // Write the counts of folded duplicates and dropped logs of a call site
+    void writeCounts(log_level level, const char * filename, const char * funcname, int line,
+                     uint64_t repeats, uint64_t dropped);
+
+private:
+    // Below the module level, or shed while the asynchronous queue is under pressure
+    bool filtered(log_level level) const
+    {
+        return level > m_level || (level > load_shedding::level() && m_engine->async());
+    }
+
+    // Sampled out and dropped logs return before render is called to format their message
+    template<typename Render>
+    void logSite(_simplelog_site & site, const rate_limit * limit, log_level level,
+                 const char * filename, const char * funcname, int line, Render && render)
+    {
+        unsigned every = 1;
+        if (filtered(level) || (m_sampler && !m_sampler->keep(level, every)))
+            return;
+        if (limit && !call_site::admit(site, *limit))
+            return call_site::defer({ &site, this, level, filename, funcname, line });
+        stage_timer timer;
+        thread_buffer buffer(thread_buffer::message);
+        memory_buffer & buf = buffer.get();
+        render(buf);
+        timer.lap(stage::message);
+        writeSite(site, limit != nullptr, every, level, filename, funcname, line, buf, timer);
+    }
+
+    // Write a message of a call site, unless it's folded as a duplicate.
+    // Sampled messages are annotated with the count of logs they stand for.
+    void writeSite(_simplelog_site & site, bool fold, unsigned every, log_level level,
+                   const char * filename, const char * funcname, int line, memory_buffer & msg,
+                   stage_timer & timer);
+
+    const std::string m_tag;
+    const log_level m_level;
+    const std::shared_ptr<logger> m_engine;
+    const bool m_limited;
+    const rate_limit m_limit;
+    const std::unique_ptr<sampler, memory_deleter> m_sampler;
+};
+
 class logger_factory
 {
 public:
@@ -134,6 +474,8 @@ public:
     static std::vector<std::shared_ptr<logger>> get(const std::string & tag,
                                                     const std::vector<std::string> & names);
     static std::vector<std::shared_ptr<logger>> get(const std::string & tag);
+    // Loggers opened so far, by name
+    static const unordered_casemap<std::shared_ptr<logger>> & loggers() { return opened(); }
 
 protected:
     logger_factory(const std::string & type);
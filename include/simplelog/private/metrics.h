@@ -0,0 +1,64 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_METRICS_H
+#define SIMPLELOG_METRICS_H
+
+#include <atomic>
+#include <cstdint>
+
+namespace simplelog {
+
+// Counter updated without any ordering, as it's only read by metrics snapshots.
+// Padded to a cache line, so that counters updated by different threads don't share one.
+class counter
+{
+public:
+    counter() { m_line.value = 0; }
+
+    // Return the value before the addition
+    uint64_t add(uint64_t n = 1) { return m_line.value.fetch_add(n, std::memory_order_relaxed); }
+    void sub(uint64_t n = 1) { m_line.value.fetch_sub(n, std::memory_order_relaxed); }
+    void max(uint64_t value)
+    {
+        uint64_t current = m_line.value.load(std::memory_order_relaxed);
+        while (value > current
+               && !m_line.value.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+    }
+    uint64_t get() const { return m_line.value.load(std::memory_order_relaxed); }
+
+private:
+    struct
+    {
+        std::atomic<uint64_t> value;
+        char padding[64 - sizeof(std::atomic<uint64_t>)];
+    } m_line;
+};
+
+// Counters of a logger, as a sink written by engines
+struct sink_metrics
+{
+    counter records;
+    counter bytes;
+    counter flushes;
+    // Write latency, sampled on 1 write out of latencySampling
+    counter writeSamples;
+    counter writeTotalNs;
+    counter writeMaxNs;
+
+    static const uint64_t latencySampling = 64;
+};
+
+// Counters of an engine
+struct engine_metrics
+{
+    counter records;
+    counter bytes;
+    counter drops;
+    counter flushes;
+};
+
+} // namespace simplelog
+
+#endif
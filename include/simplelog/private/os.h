@@ -5,12 +5,17 @@
 #ifndef SIMPLELOG_OS_H
 #define SIMPLELOG_OS_H
 
+#include <cerrno>
+#include <cstdio>
+
 #ifdef _WIN32
 #include <process.h>
 #include <processthreadsapi.h>
-#elif defined(__linux__)
-#include <sys/syscall.h>
+#else
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 #endif
 
 #if defined(thread_local)
@@ -37,13 +42,32 @@ public:
     static size_t getThreadId()
     {
 #ifdef THREAD_LOCAL
-        THREAD_LOCAL static const size_t tid = getThreadIdImpl();
+        size_t & tid = cachedThreadId();
+        if (tid == 0)
+            tid = getThreadIdImpl();
         return tid;
 #else
         return std::hash<std::thread::id>()(std::this_thread::get_id());
 #endif
     }
 
+    // Forget the cached id of the calling thread, as it changes in a forked child
+    static void resetThreadId()
+    {
+#ifdef THREAD_LOCAL
+        cachedThreadId() = 0;
+#endif
+    }
+
+    static long getProcessId()
+    {
+#ifdef _WIN32
+        return static_cast<long>(_getpid());
+#else
+        return static_cast<long>(getpid());
+#endif
+    }
+
     static const char * getEol()
     {
 #ifdef _WIN32
@@ -53,7 +77,53 @@ public:
 #endif
     }
 
+    // Write all of data to a file descriptor. Async-signal-safe, for the crash handler.
+    static void writeFd(int fd, const char * data, size_t len)
+    {
+#ifndef _WIN32
+        while (len > 0) {
+            const ssize_t n = ::write(fd, data, len);
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return;
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+#else
+        (void)fd;
+        (void)data;
+        (void)len;
+#endif
+    }
+
+    // Write the data buffered by a stdio stream to its file descriptor from a signal handler,
+    // where fflush could deadlock on the stream lock. The buffer is only known on glibc: on other
+    // libcs, the data buffered by the stream is lost on a crash. Loggers owning their stream
+    // rather keep their own buffer.
+    static void drainFile(FILE * file, int fd)
+    {
+#ifdef __GLIBC__
+        if (file && file->_IO_write_ptr > file->_IO_write_base) {
+            writeFd(fd, file->_IO_write_base,
+                    static_cast<size_t>(file->_IO_write_ptr - file->_IO_write_base));
+            file->_IO_write_ptr = file->_IO_write_base;
+        }
+#else
+        (void)file;
+        (void)fd;
+#endif
+    }
+
 private:
+#ifdef THREAD_LOCAL
+    static size_t & cachedThreadId()
+    {
+        THREAD_LOCAL static size_t tid = 0;
+        return tid;
+    }
+#endif
+
     static size_t getThreadIdImpl()
     {
 #ifdef _WIN32
@@ -0,0 +1,78 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_PRINTF_FORMAT
+#define SIMPLELOG_PRINTF_FORMAT
+
+#include <cstdarg>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "allocator.h"
+#include "formatter.h"
+
+namespace simplelog {
+
+// printf format string parsed once into a list of conversions, so that logs from a call site
+// don't parse their format again. Arguments are rendered with fast integer and floating point
+// conversions, uncommon conversions being delegated to snprintf one at a time.
+class printf_format
+{
+public:
+    // Return the format compiled for a call site, compiling it on first use.
+    // cache is a call site slot, only ever used with the same literal format.
+    // Return nullptr if the format can't be compiled (positional arguments, "*" width, %n...),
+    // or if there's no memory left to compile it (i.e. real-time pool exhausted)
+    static const printf_format * get(void ** cache, const char * format);
+
+    void render(memory_buffer & buffer, va_list args) const;
+
+private:
+    enum class arg_type : uint8_t
+    {
+        none, // Literal text
+        int_,
+        long_,
+        longlong_,
+        intmax_,
+        size_,
+        ptrdiff_,
+        double_,
+        longdouble_,
+        string_,
+        pointer_
+    };
+    struct conversion
+    {
+        arg_type arg;
+        bool isUnsigned;
+        uint8_t narrow; // sizeof the hh/h argument, 0 otherwise
+        bool simple;    // No flags nor width, precision only for strings and floats
+        char conv;
+        int precision;
+        size_t offset; // Literal text or snprintf spec, in m_text
+        size_t len;
+    };
+
+    printf_format(const char * format);
+    bool compile();
+
+    template<typename T>
+    void appendInteger(memory_buffer & buffer, const conversion & c, T value) const;
+    void appendFloat(memory_buffer & buffer, const conversion & c, double value) const;
+    void appendString(memory_buffer & buffer, const conversion & c, const char * value) const;
+    template<typename T>
+    void appendSnprintf(memory_buffer & buffer, const conversion & c, T value) const;
+
+    const char * m_format;
+    // Format followed by the nul terminated snprintf spec of each conversion.
+    // Allocated on a call site first log, which falls back to vsnprintf without memory.
+    std::basic_string<char, std::char_traits<char>, allocator<char, true>> m_text;
+    std::vector<conversion, allocator<conversion, true>> m_conversions;
+};
+
+} // namespace simplelog
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_RENDER_H
+#define SIMPLELOG_RENDER_H
+
+#include <cstddef>
+#include <fmt/format.h>
+#include <type_traits>
+
+namespace simplelog {
+
+// Low level text rendering shared by formatters.
+// Fixed width fields are written two digits at a time from a lookup table.
+class render
+{
+public:
+    // Write value (< 100) as 2 digits, and return the end of the written text
+    static char * twoDigits(char * out, unsigned value)
+    {
+        const char * digits = &m_digits[value * 2];
+        out[0] = digits[0];
+        out[1] = digits[1];
+        return out + 2;
+    }
+    // Write value (< 1000) as 3 digits
+    static char * threeDigits(char * out, unsigned value)
+    {
+        *out++ = static_cast<char>('0' + value / 100);
+        return twoDigits(out, value % 100);
+    }
+    // Write value (< 10000) as 4 digits
+    static char * fourDigits(char * out, unsigned value)
+    {
+        return twoDigits(twoDigits(out, value / 100), value % 100);
+    }
+    // Write the count last digits of value, left padded with zeros
+    static char * digits(char * out, unsigned value, int count)
+    {
+        char * end = out + count;
+        char * p = end;
+        for (; count >= 2; count -= 2) {
+            p -= 2;
+            twoDigits(p, value % 100);
+            value /= 100;
+        }
+        if (count)
+            *--p = static_cast<char>('0' + value % 10);
+        return end;
+    }
+
+    // Append value, left padded with zeros up to width digits
+    template<typename Buffer, typename T,
+             typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    static void decimal(Buffer & buffer, T value, int width = 0)
+    {
+        fmt::format_int i(value);
+        for (int n = static_cast<int>(i.size()); n < width; n++)
+            buffer.push_back('0');
+        buffer.append(i.data(), i.data() + i.size());
+    }
+
+private:
+    static const char m_digits[201];
+};
+
+} // namespace simplelog
+
+#endif
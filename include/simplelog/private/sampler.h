@@ -0,0 +1,81 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_SAMPLER_H
+#define SIMPLELOG_SAMPLER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "log_metadata.h"
+
+namespace simplelog {
+
+// Sampling of a level: keep 1 log out of every, or about perSecond logs per second
+struct sample_rate
+{
+    unsigned every = 0;
+    double perSecond = 0;
+
+    bool enabled() const { return every > 1 || perSecond > 0; }
+};
+// Sampling of each level, indexed by log_level
+using sample_rates = std::array<sample_rate, static_cast<size_t>(log_level::verbose) + 1>;
+
+// Probabilistic sampling of the logs of a module.
+// A fixed rate only costs a thread local pseudo random draw. A target rate also counts the logs
+// of the level, and adapts its 1 out of N every second from the rate observed.
+class sampler
+{
+public:
+    explicit sampler(const sample_rates & rates);
+
+    static bool any(const sample_rates & rates);
+
+    // Whether to keep a log, before formatting it. every is then the count of logs it stands for.
+    bool keep(log_level level, unsigned & every)
+    {
+        level_state & l = m_levels[static_cast<size_t>(level)];
+        if (!l.rate.enabled()) {
+            every = 1;
+            return true;
+        }
+        if (l.rate.perSecond > 0)
+            adapt(l);
+        every = l.every.load(std::memory_order_relaxed);
+        return every <= 1 || random() % every == 0;
+    }
+
+private:
+    struct level_state
+    {
+        sample_rate rate;
+        std::atomic<unsigned> every;
+        std::atomic<uint64_t> seen;
+        std::atomic<uint64_t> windowSeen;
+        std::atomic<int64_t> windowStart;
+    };
+
+    static void adapt(level_state & l);
+
+    // xorshift64*, one sequence per thread
+    static uint64_t random()
+    {
+        static thread_local uint64_t state = 0;
+        if (state == 0)
+            state = seed();
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return (state * 0x2545F4914F6CDD1Dull) >> 32;
+    }
+    static uint64_t seed();
+
+    std::array<level_state, std::tuple_size<sample_rates>::value> m_levels;
+};
+
+} // namespace simplelog
+
+#endif
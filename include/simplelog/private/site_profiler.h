@@ -0,0 +1,52 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_SITE_PROFILER_H
+#define SIMPLELOG_SITE_PROFILER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "log_metadata.h"
+
+namespace simplelog {
+
+// Optional count of the lines and bytes written by each call site (file, line, tag, level),
+// to find the noisiest logs. Counters are kept per thread, and only summed up when dumped.
+class site_profiler
+{
+public:
+    struct site
+    {
+        const char * tag;
+        log_level level;
+        const char * file;
+        int line;
+        uint64_t records;
+        uint64_t bytes;
+    };
+
+    // Start or stop counting. When summaryInterval isn't 0, the noisiest sites are logged
+    // every summaryInterval seconds.
+    static void configure(bool enabled, unsigned summaryInterval);
+    static bool enabled() { return m_enabled.load(std::memory_order_relaxed); }
+
+    // Count a line written by a call site. tag and file must live as long as the process.
+    static void record(const char * tag, log_level level, const char * file, int line,
+                       size_t bytes);
+
+    // Sites which wrote the most bytes, from all threads since counting started
+    static std::vector<site> top(size_t count);
+
+private:
+    static void summarize();
+
+    static std::atomic_bool m_enabled;
+};
+
+} // namespace simplelog
+
+#endif
@@ -0,0 +1,121 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_STAGE_TIMING_H
+#define SIMPLELOG_STAGE_TIMING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace simplelog {
+
+// Stages of a log, from the call to the loggers
+enum class stage
+{
+    message, // User message formatting
+    line,    // Formatter (metadata and message)
+    lock,    // Wait for the engine lock
+    consume, // Engine: queueing when asynchronous, loggers writes when synchronous
+    queue,   // Wait in the asynchronous queue
+    write,   // Loggers writes by the asynchronous writer thread
+    count
+};
+
+// Optional timing of the stages of 1 log out of N, aggregated in histograms of durations.
+// Logs that aren't sampled only cost a thread local counter decrement.
+class stage_timing
+{
+public:
+    static const int bucketCount = 32;
+    struct histogram
+    {
+        std::atomic<uint64_t> samples;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint64_t> maxNs;
+        // buckets[i] counts the durations from 2^i to 2^(i+1)-1 ns, 0 being counted in buckets[0]
+        std::atomic<uint64_t> buckets[bucketCount];
+    };
+
+    // Time 1 log out of interval, 0 to disable
+    static void setSampling(unsigned interval);
+
+    // Whether the log starting on this thread is timed
+    static bool sample()
+    {
+        unsigned & countdown = countdownRef();
+        if (--countdown != 0)
+            return false;
+        return resample(countdown);
+    }
+    // Whether the log in progress on this thread is timed
+    static bool sampling() { return samplingRef(); }
+
+    static int64_t now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+    static void add(stage s, int64_t ns);
+    static const histogram & get(stage s) { return m_histograms[static_cast<int>(s)]; }
+    static const char * name(stage s);
+
+private:
+    friend class stage_timer;
+
+    static unsigned & countdownRef()
+    {
+        static thread_local unsigned countdown = 1;
+        return countdown;
+    }
+    static bool & samplingRef()
+    {
+        static thread_local bool sampling = false;
+        return sampling;
+    }
+    static bool resample(unsigned & countdown);
+
+    static std::atomic<unsigned> m_interval;
+    static histogram m_histograms[static_cast<int>(stage::count)];
+};
+
+// Times the stages of a log in progress, if it's sampled
+class stage_timer
+{
+public:
+    stage_timer() :
+        m_last(stage_timing::sample() ? stage_timing::now() : 0),
+        m_outer(stage_timing::samplingRef())
+    {
+        if (m_last)
+            stage_timing::samplingRef() = true;
+    }
+    // A timer may be nested in the one of the log that writes it, ie. for a repeats count
+    ~stage_timer()
+    {
+        if (m_last)
+            stage_timing::samplingRef() = m_outer;
+    }
+    stage_timer(const stage_timer &) = delete;
+    stage_timer & operator=(const stage_timer &) = delete;
+
+    // Account for the time since the previous stage
+    void lap(stage s)
+    {
+        if (!m_last)
+            return;
+        const int64_t now = stage_timing::now();
+        stage_timing::add(s, now - m_last);
+        m_last = now;
+    }
+
+private:
+    int64_t m_last;
+    const bool m_outer;
+};
+
+} // namespace simplelog
+
+#endif
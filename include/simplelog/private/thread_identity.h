@@ -0,0 +1,42 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_THREAD_IDENTITY_H
+#define SIMPLELOG_THREAD_IDENTITY_H
+
+#include <cstddef>
+
+namespace simplelog {
+
+// Text identifying a thread in logs: "<tid>", or "<tid>:<name>" once the thread is named.
+// It's rendered once per thread, so that formatters only have to copy it.
+class thread_identity
+{
+public:
+    // Identity of the calling thread
+    static const thread_identity & get();
+    // Name the calling thread, or remove its name if name is null or empty
+    static void setName(const char * name);
+    // Render the identity of the calling thread again, with its id in a forked child
+    static void reset();
+
+    size_t tid() const { return m_tid; }
+    const char * data() const { return m_text; }
+    size_t size() const { return m_length; }
+
+private:
+    thread_identity();
+    static thread_identity & current();
+    void render();
+
+    static const size_t m_maxNameLength = 47;
+    size_t m_tid;
+    size_t m_length;
+    char m_name[m_maxNameLength + 1];
+    char m_text[m_maxNameLength + 24];
+};
+
+} // namespace simplelog
+
+#endif
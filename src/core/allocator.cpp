@@ -0,0 +1,179 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "allocator.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "logger.h"
+
+using namespace simplelog;
+
+namespace {
+struct hooks
+{
+    void * (*alloc)(size_t size, void * ctx);
+    void (*release)(void * ptr, void * ctx);
+    void * ctx;
+};
+void * defaultAlloc(size_t size, void *) { return malloc(size); }
+void defaultRelease(void * ptr, void *) { free(ptr); }
+hooks & currentHooks()
+{
+    static hooks h{ defaultAlloc, defaultRelease, nullptr };
+    return h;
+}
+
+// Bounded pool of blocks, allocated once when enabling the real-time mode.
+// Small allocations are served from blocks split into chunks of a size class, so that a node
+// doesn't take a whole block. Blocks split for a size class stay in that class.
+class realtime_pool
+{
+public:
+    realtime_pool() : m_begin(nullptr), m_end(nullptr), m_classes(nullptr), m_enabled(false) {}
+
+    bool enable(size_t size)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t count = size / memory::blockSize;
+        if (m_enabled.load(std::memory_order_relaxed) || count == 0)
+            return false;
+        auto & h = currentHooks();
+        char * begin = static_cast<char *>(h.alloc(count * memory::blockSize, h.ctx));
+        if (!begin)
+            return false;
+        m_classes = static_cast<unsigned char *>(h.alloc(count, h.ctx));
+        if (!m_classes) {
+            h.release(begin, h.ctx);
+            return false;
+        }
+        m_begin = begin;
+        m_end = begin + count * memory::blockSize;
+        for (auto & f : m_free)
+            f = nullptr;
+        for (size_t i = count; i > 0; i--) {
+            m_classes[i - 1] = wholeBlock;
+            push(wholeBlock, m_begin + (i - 1) * memory::blockSize);
+        }
+        // Publishes m_begin and m_end to owns()
+        m_enabled.store(true, std::memory_order_release);
+        return true;
+    }
+    bool enabled() const { return m_enabled.load(std::memory_order_acquire); }
+    bool owns(void * ptr) const
+    {
+        return m_enabled.load(std::memory_order_acquire) && ptr >= m_begin && ptr < m_end;
+    }
+
+    void * allocate(size_t size)
+    {
+        size_t c = 0;
+        while (c < wholeBlock && classSize(c) < size)
+            c++;
+        if (classSize(c) < size)
+            return nullptr;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free[c] && c != wholeBlock && !split(c))
+            return nullptr;
+        block * b = m_free[c];
+        if (b)
+            m_free[c] = b->next;
+        return b;
+    }
+    void release(void * ptr)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        push(m_classes[(static_cast<char *>(ptr) - m_begin) / memory::blockSize], ptr);
+    }
+
+private:
+    struct block
+    {
+        block * next;
+    };
+    // Chunks of 64 bytes to 16 KiB, then whole blocks
+    static const size_t wholeBlock = 5;
+    static size_t classSize(size_t c)
+    {
+        return c == wholeBlock ? memory::blockSize : size_t(64) << (2 * c);
+    }
+
+    void push(size_t c, void * ptr)
+    {
+        auto b = static_cast<block *>(ptr);
+        b->next = m_free[c];
+        m_free[c] = b;
+    }
+    // Split a whole block into chunks of class c
+    bool split(size_t c)
+    {
+        block * b = m_free[wholeBlock];
+        if (!b)
+            return false;
+        m_free[wholeBlock] = b->next;
+        char * begin = reinterpret_cast<char *>(b);
+        m_classes[(begin - m_begin) / memory::blockSize] = static_cast<unsigned char>(c);
+        for (size_t offset = memory::blockSize; offset > 0; offset -= classSize(c))
+            push(c, begin + offset - classSize(c));
+        return true;
+    }
+
+    std::mutex m_mutex;
+    char * m_begin;
+    char * m_end;
+    // Size class of each block
+    unsigned char * m_classes;
+    block * m_free[wholeBlock + 1];
+    std::atomic_bool m_enabled;
+};
+realtime_pool & pool()
+{
+    static realtime_pool p;
+    return p;
+}
+} // namespace
+
+void * memory::allocate(size_t size)
+{
+    void * ptr = tryAllocate(size);
+    if (!ptr) {
+        fprintf(stderr, "simplelog: unable to allocate %zu bytes%s\n", size,
+                pool().enabled() ? " in real-time mode" : "");
+        abort();
+    }
+    return ptr;
+}
+
+void * memory::tryAllocate(size_t size)
+{
+    if (pool().enabled())
+        return pool().allocate(size);
+    auto & h = currentHooks();
+    return h.alloc(size == 0 ? 1 : size, h.ctx);
+}
+
+void memory::release(void * ptr)
+{
+    if (!ptr)
+        return;
+    if (pool().owns(ptr)) {
+        pool().release(ptr);
+    } else {
+        auto & h = currentHooks();
+        h.release(ptr, h.ctx);
+    }
+}
+
+extern "C" void _simplelog_set_allocator(void * (*alloc)(size_t size, void * ctx),
+                                         void (*release)(void * ptr, void * ctx), void * ctx)
+{
+    if (!alloc || !release)
+        return;
+    currentHooks() = hooks{ alloc, release, ctx };
+}
+
+extern "C" int _simplelog_realtime(size_t pool_size) { return pool().enable(pool_size) ? 0 : -1; }
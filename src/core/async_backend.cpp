@@ -0,0 +1,404 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "async_backend.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "allocator.h"
+#include "crash_handler.h"
+#include "load_shedding.h"
+#include "stage_timing.h"
+
+using namespace simplelog;
+
+const size_t async_backend::m_maxQueueSize = LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE;
+const size_t async_backend::m_cacheLineSize = 64;
+// Fit regular slabs in memory blocks, so that they can be served by the real-time pool
+const size_t async_backend::m_slabCapacity =
+        memory::blockSize - sizeof(async_backend::slab) - m_cacheLineSize;
+const std::string async_backend::m_overflowMessage = "ERROR: Log overflow!";
+std::atomic<async_backend *> async_backend::m_instance(nullptr);
+
+std::shared_ptr<async_backend> async_backend::get()
+{
+    // Only keep the backend alive while asynchronous engines are using it
+    static std::mutex mutex;
+    static std::weak_ptr<async_backend> instance;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto backend = instance.lock();
+    if (!backend) {
+        backend.reset(new async_backend());
+        instance = backend;
+    }
+    return backend;
+}
+
+async_backend::slab * async_backend::newSlab(size_t capacity)
+{
+    auto mem = static_cast<char *>(memory::tryAllocate(sizeof(slab) + m_cacheLineSize + capacity));
+    if (!mem)
+        return nullptr;
+    auto s = new (mem) slab{ mem + sizeof(slab), capacity, 0, nullptr };
+    // Align records on cache lines
+    auto offset = reinterpret_cast<uintptr_t>(s->data) % m_cacheLineSize;
+    if (offset != 0)
+        s->data += m_cacheLineSize - offset;
+    return s;
+}
+
+void async_backend::slab_list::push(slab * s)
+{
+    s->next = nullptr;
+    if (tail)
+        tail->next = s;
+    else
+        head = s;
+    tail = s;
+}
+
+async_backend::slab * async_backend::slab_list::pop()
+{
+    slab * s = head;
+    if (s) {
+        head = s->next;
+        if (!head)
+            tail = nullptr;
+    }
+    return s;
+}
+
+async_backend::async_backend() :
+    m_running(true),
+    m_flushRequest(0),
+    m_flushAck(0),
+    m_cv(new std::condition_variable()),
+    m_ackCv(new std::condition_variable()),
+    m_queueSize(0),
+    m_sheddingChanged(false),
+    m_sheddingFill(0),
+    m_writing(nullptr)
+{
+    // Slabs for the queue being filled and the one being written
+    for (int i = 0; i < 2; i++) {
+        if (slab * s = newSlab(m_slabCapacity))
+            m_freeSlabs.push(s);
+    }
+    m_thread.reset(new std::thread(&async_backend::threadEntry, this));
+    m_instance = this;
+}
+
+async_backend::~async_backend()
+{
+    m_instance = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cv->notify_one();
+    m_thread->join();
+    while (slab * s = m_freeSlabs.pop())
+        memory::release(s);
+}
+
+void async_backend::attach(async_destination * destination)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_destinations.push_back(destination);
+    }
+    crash_handler::update();
+}
+
+void async_backend::detach(async_destination * destination)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_destinations.erase(std::remove(m_destinations.begin(), m_destinations.end(), destination),
+                             m_destinations.end());
+    }
+    crash_handler::update();
+    // Wait for queued records still referencing that destination. Its loggers are then flushed
+    // here, as the writer thread only flushes the loggers of attached destinations.
+    flush();
+    for (auto & logger : destination->loggers)
+        logger->flushRaw();
+}
+
+bool async_backend::push(async_destination & destination, log_level level, const char * msg,
+                         size_t len)
+{
+    const size_t size = recordSize(len);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    updateShedding();
+    // Each engine may queue up to the max queue size, so that a noisy one doesn't starve the others
+    if (destination.queued.get() >= m_maxQueueSize) {
+        destination.overflow = true;
+        return false;
+    }
+    slab * s = m_queue.tail;
+    if (!s || s->capacity - s->used < size) {
+        s = acquireSlab(size);
+        if (!s) {
+            destination.overflow = true;
+            return false;
+        }
+        m_queue.push(s);
+    }
+    auto r = reinterpret_cast<record *>(s->data + s->used);
+    r->destination = &destination;
+    r->level = level;
+    r->len = len;
+    r->queued = stage_timing::sampling() ? stage_timing::now() : 0;
+    memcpy(r + 1, msg, len);
+    s->used += size;
+    destination.maxQueued.max(destination.queued.add() + 1);
+    // Writer thread only waits on an empty queue
+    if (++m_queueSize == 1)
+        m_cv->notify_one();
+    return true;
+}
+
+async_backend::slab * async_backend::acquireSlab(size_t size)
+{
+    // Records bigger than a slab get their own slab, released once written
+    if (size > m_slabCapacity)
+        return newSlab(size);
+    slab * s = m_freeSlabs.pop();
+    return s ? s : newSlab(m_slabCapacity);
+}
+
+void async_backend::releaseSlabs(slab_list & slabs)
+{
+    while (slab * s = slabs.pop()) {
+        if (s->capacity > m_slabCapacity) {
+            memory::release(s);
+        } else {
+            s->used = 0;
+            m_freeSlabs.push(s);
+        }
+    }
+}
+
+void async_backend::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t request = ++m_flushRequest;
+    m_cv->notify_one();
+    m_ackCv->wait(lock, [&] { return m_flushAck >= request || !m_running; });
+}
+
+void async_backend::threadEntry()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running || m_queueSize != 0) {
+        m_cv->wait(lock, [this] {
+            return !m_running || m_queueSize != 0 || m_flushRequest != m_flushAck
+                   || m_sheddingChanged;
+        });
+        std::swap(m_queue, m_workingQueue);
+        m_queueSize = 0;
+        m_workingDestinations = m_destinations;
+        const uint64_t flushRequest = m_flushRequest;
+        const bool sheddingChanged = m_sheddingChanged;
+        const log_level sheddingLevel = load_shedding::level();
+        const size_t sheddingFill = m_sheddingFill;
+        m_sheddingChanged = false;
+        lock.unlock();
+
+        if (sheddingChanged)
+            writeShedding(sheddingLevel, sheddingFill);
+
+        auto begin = std::chrono::steady_clock::now();
+        for (auto s = m_workingQueue.head; s; s = s->next) {
+            for (size_t pos = 0; pos < s->used;) {
+                auto r = reinterpret_cast<const record *>(s->data + pos);
+                m_writing.store(r, std::memory_order_relaxed);
+                const int64_t dequeued = r->queued ? stage_timing::now() : 0;
+                for (auto & logger : r->destination->loggers)
+                    logger->writeRaw(r->level, r->text(), r->len);
+                if (r->queued) {
+                    stage_timing::add(stage::queue, dequeued - r->queued);
+                    stage_timing::add(stage::write, stage_timing::now() - dequeued);
+                }
+                r->destination->queued.sub();
+                pos += recordSize(r->len);
+            }
+        }
+        m_writing.store(nullptr, std::memory_order_relaxed);
+        writeOverflows();
+        if (flushRequest != m_flushAck)
+            flushLoggers();
+        auto end = std::chrono::steady_clock::now();
+
+        lock.lock();
+        releaseSlabs(m_workingQueue);
+        updateShedding();
+        if (flushRequest != m_flushAck) {
+            m_flushAck = flushRequest;
+            m_ackCv->notify_all();
+        }
+
+        // Don't loop immediatly so the queue can be filled efficiently
+        if (m_running
+            && std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() == 0) {
+            lock.unlock();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            lock.lock();
+        }
+    }
+}
+
+void async_backend::writeOverflows()
+{
+    for (auto destination : m_workingDestinations) {
+        bool expected = true;
+        if (destination->overflow.compare_exchange_strong(expected, false)) {
+            for (auto & logger : destination->loggers)
+                logger->writeRaw(log_level::warning, m_overflowMessage.c_str(),
+                                 m_overflowMessage.size());
+        }
+    }
+}
+
+void async_backend::crashLoggers(void (*callback)(logger & l))
+{
+    async_backend * backend = m_instance.load();
+    if (!backend)
+        return;
+    std::lock_guard<std::mutex> lock(backend->m_mutex);
+    for (auto destination : backend->m_destinations) {
+        for (auto & logger : destination->loggers)
+            callback(*logger);
+    }
+}
+
+void async_backend::crashDrain()
+{
+    async_backend * backend = m_instance.load();
+    if (!backend)
+        return;
+    // Records of the working queue are written from the one being written, if any
+    const record * writing = backend->m_writing.load(std::memory_order_relaxed);
+    if (writing)
+        crashWrite(backend->m_workingQueue, writing);
+    crashWrite(backend->m_queue, nullptr);
+}
+
+void async_backend::crashWrite(slab_list & slabs, const record * from)
+{
+    bool started = from == nullptr;
+    for (auto s = slabs.head; s; s = s->next) {
+        for (size_t pos = 0; pos < s->used;) {
+            auto r = reinterpret_cast<const record *>(s->data + pos);
+            started = started || r == from;
+            if (started) {
+                for (auto & logger : r->destination->loggers) {
+                    const int fd = logger->crashFd();
+                    if (fd >= 0)
+                        os::writeFd(fd, r->text(), r->len);
+                }
+            }
+            pos += recordSize(r->len);
+        }
+    }
+}
+
+void async_backend::prepareFork()
+{
+    async_backend * backend = m_instance.load();
+    if (!backend)
+        return;
+    std::unique_lock<std::mutex> lock(backend->m_mutex);
+    // Records still queued would be written by both processes
+    do {
+        const uint64_t request = ++backend->m_flushRequest;
+        backend->m_cv->notify_one();
+        backend->m_ackCv->wait(lock, [&] {
+            return backend->m_flushAck >= request || !backend->m_running;
+        });
+    } while (backend->m_queueSize != 0 && backend->m_running);
+    // Unlocked in the parent and in the child once forked
+    lock.release();
+}
+
+void async_backend::parentFork()
+{
+    async_backend * backend = m_instance.load();
+    if (backend)
+        backend->m_mutex.unlock();
+}
+
+void async_backend::childFork()
+{
+    async_backend * backend = m_instance.load();
+    if (!backend)
+        return;
+    // The writer thread of the parent doesn't exist in the child, nor do the waiters of its
+    // condition variables: they can't be joined nor destroyed, and are leaked on purpose
+    backend->m_cv.release();
+    backend->m_ackCv.release();
+    backend->m_thread.release();
+    backend->m_cv.reset(new std::condition_variable());
+    backend->m_ackCv.reset(new std::condition_variable());
+    backend->m_thread.reset(new std::thread(&async_backend::threadEntry, backend));
+    backend->m_mutex.unlock();
+}
+
+void async_backend::updateShedding()
+{
+    if (!load_shedding::enabled())
+        return;
+    // Each engine may queue up to the max queue size: the fill is the one of the fullest
+    uint64_t queued = 0;
+    for (auto destination : m_destinations)
+        queued = std::max(queued, destination->queued.get());
+    const size_t fill = static_cast<size_t>(std::min<uint64_t>(queued, m_maxQueueSize));
+    if (load_shedding::update(fill, m_maxQueueSize)) {
+        m_sheddingChanged = true;
+        m_sheddingFill = fill * 100 / m_maxQueueSize;
+    }
+}
+
+void async_backend::writeShedding(log_level level, size_t fill)
+{
+    static const char * levels[] = { "disabled", "panic", "error", "warning",
+                                     "info",     "debug", "verbose" };
+    // Formatted with the allocator of the logs, as the writer thread doesn't allocate otherwise
+    memory_buffer msg;
+    if (level == log_level::verbose)
+        fmt::format_to(fmt::appender(msg), FMT_COMPILE("INFO: Log queue {}% full, all logs kept"),
+                       fill);
+    else
+        fmt::format_to(fmt::appender(msg),
+                       FMT_COMPILE("WARNING: Log queue {}% full, logs above {} dropped"), fill,
+                       levels[level]);
+    const char * eol = os::getEol();
+    msg.append(eol, eol + strlen(eol));
+    collectLoggers();
+    for (auto logger : m_workingLoggers)
+        logger->writeRaw(level == log_level::verbose ? log_level::info : log_level::warning,
+                         msg.data(), msg.size());
+}
+
+void async_backend::collectLoggers()
+{
+    // Loggers may be shared between several destinations, only keep them once
+    m_workingLoggers.clear();
+    for (auto destination : m_workingDestinations) {
+        for (auto & logger : destination->loggers) {
+            if (std::find(m_workingLoggers.begin(), m_workingLoggers.end(), logger.get())
+                == m_workingLoggers.end())
+                m_workingLoggers.push_back(logger.get());
+        }
+    }
+}
+
+void async_backend::flushLoggers()
+{
+    collectLoggers();
+    for (auto logger : m_workingLoggers)
+        logger->flushRaw();
+}
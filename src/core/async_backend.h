@@ -0,0 +1,145 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_ASYNC_BACKEND
+#define SIMPLELOG_ASYNC_BACKEND
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "logger.h"
+
+namespace simplelog {
+
+// Loggers targeted by an asynchronous engine
+struct async_destination
+{
+    async_destination(const std::vector<std::shared_ptr<logger>> & l) :
+        loggers(l), overflow(false)
+    {}
+
+    std::vector<std::shared_ptr<logger>> loggers;
+    std::atomic_bool overflow;
+    counter queued;
+    counter maxQueued;
+};
+
+// Single writer thread shared by every asynchronous engine.
+// Each logger is only ever written from this thread, so loggers shared between
+// several engines (same file for several tags) never contend with each other.
+class async_backend
+{
+public:
+    static std::shared_ptr<async_backend> get();
+    ~async_backend();
+
+    void attach(async_destination * destination);
+    void detach(async_destination * destination);
+    // Return false if the queue is full
+    bool push(async_destination & destination, log_level level, const char * msg, size_t len);
+    void flush();
+
+    // Crash handler support. Call callback on the loggers of each attached engine, for the
+    // snapshot of the crash handler, taken outside of it.
+    static void crashLoggers(void (*callback)(logger & l));
+    // From a signal handler: without lock nor allocation, nor any synchronization with the
+    // writer thread, as it may itself be the crashing thread.
+    // Write the records not written yet to the crashFd() of their loggers. The record being
+    // written by the writer thread is written again.
+    static void crashDrain();
+
+    // Fork support, from pthread_atfork handlers. The queue is drained, then kept locked across
+    // the fork with the writer thread idle. The child then restarts its own writer thread.
+    static void prepareFork();
+    static void parentFork();
+    static void childFork();
+
+private:
+    // Records are stored contiguously in cache line aligned slabs, recycled once written,
+    // so that logging doesn't allocate once enough slabs are available.
+    struct record
+    {
+        async_destination * destination;
+        log_level level;
+        size_t len;
+        // Queueing time of a timed log, 0 otherwise
+        int64_t queued;
+        const char * text() const { return reinterpret_cast<const char *>(this + 1); }
+    };
+    struct slab
+    {
+        char * data;
+        size_t capacity;
+        size_t used;
+        slab * next;
+    };
+    // Intrusive list of slabs, so that queuing never allocates
+    struct slab_list
+    {
+        slab_list() : head(nullptr), tail(nullptr) {}
+        void push(slab * s);
+        slab * pop();
+
+        slab * head;
+        slab * tail;
+    };
+
+    async_backend();
+    async_backend(const async_backend &) = delete;
+    async_backend & operator=(const async_backend &) = delete;
+
+    // Size of a record and its text, padded to keep the next record aligned
+    static size_t recordSize(size_t len)
+    {
+        return (sizeof(record) + len + m_cacheLineSize - 1) & ~(m_cacheLineSize - 1);
+    }
+    static slab * newSlab(size_t size);
+    slab * acquireSlab(size_t size);
+    void releaseSlabs(slab_list & slabs);
+    void threadEntry();
+    void writeOverflows();
+    // Report a change of the load shedding level
+    void updateShedding();
+    void writeShedding(log_level level, size_t fill);
+    // Distinct loggers of the working destinations, in m_workingLoggers
+    void collectLoggers();
+    void flushLoggers();
+    static void crashWrite(slab_list & slabs, const record * from);
+
+    bool m_running;
+    uint64_t m_flushRequest;
+    uint64_t m_flushAck;
+    std::mutex m_mutex;
+    // Held through pointers, so that a forked child can drop those of its parent
+    std::unique_ptr<std::condition_variable> m_cv;
+    std::unique_ptr<std::condition_variable> m_ackCv;
+    size_t m_queueSize;
+    // Load shedding level changed since the last batch, with the queue fill in percents
+    bool m_sheddingChanged;
+    size_t m_sheddingFill;
+    slab_list m_queue;
+    slab_list m_workingQueue;
+    slab_list m_freeSlabs;
+    std::vector<async_destination *> m_destinations;
+    std::vector<async_destination *> m_workingDestinations;
+    std::vector<logger *> m_workingLoggers;
+    std::unique_ptr<std::thread> m_thread;
+    // Record being written by the writer thread, for the crash handler
+    std::atomic<const record *> m_writing;
+
+    static std::atomic<async_backend *> m_instance;
+
+    static const size_t m_maxQueueSize;
+    static const size_t m_slabCapacity;
+    static const size_t m_cacheLineSize;
+    static const std::string m_overflowMessage;
+};
+
+} // namespace simplelog
+
+#endif
@@ -5,44 +5,30 @@
 #ifndef SIMPLELOG_ASYNC_CONSUMER
 #define SIMPLELOG_ASYNC_CONSUMER
 
-#include <atomic>
-#include <condition_variable>
-#include <mutex>
-#include <queue>
-#include <thread>
+#include <memory>
+#include "async_backend.h"
 #include "iconsumer.h"
 #include "logger.h"
 
 namespace simplelog {
 
+// Submit logs to the shared asynchronous backend
 class async_consumer : public iconsumer
 {
 public:
     async_consumer(const std::vector<std::shared_ptr<logger>> & loggers);
     virtual ~async_consumer();
 
-    virtual void consume(log_level level, const char * msg, size_t len) override final;
+    virtual bool consume(log_level level, const char * msg, size_t len) override final;
     virtual void flush() override final;
+    virtual void queueDepth(uint64_t & current, uint64_t & max) const override final;
 
 private:
     async_consumer(const async_consumer &) = delete;
     async_consumer & operator=(const async_consumer &) = delete;
 
-    void threadEntry();
-
-    std::vector<std::shared_ptr<logger>> m_loggers;
-    std::atomic_bool m_running;
-    std::atomic_bool m_flushing;
-    std::atomic_bool m_overflow;
-    std::mutex m_mutex;
-    std::condition_variable m_cv;
-    std::condition_variable m_ackCv;
-    std::vector<std::pair<log_level, std::string>> m_queue;
-    std::vector<std::pair<log_level, std::string>> m_workingQueue;
-    std::thread m_thread;
-
-    static const size_t m_maxQueueSize;
-    static const std::string m_overflowMessage;
+    async_destination m_destination;
+    std::shared_ptr<async_backend> m_backend;
 };
 
 } // namespace simplelog
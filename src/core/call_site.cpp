@@ -0,0 +1,278 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "call_site.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "logger.h"
+
+using namespace simplelog;
+
+namespace {
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+// FNV-1a, never 0 as the hash of a site without message yet
+uint64_t hash(string_view msg)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (char c : msg) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+    }
+    return h | 1;
+}
+
+// Reports the pending sites from a thread of its own, started along with the first one
+class site_reporter
+{
+public:
+    // Constructed after the modules and engines it writes to, and thus destroyed before them
+    static site_reporter & get()
+    {
+        static site_reporter reporter;
+        return reporter;
+    }
+    static site_reporter * instance() { return m_instance.load(); }
+    // Sites suppressing logs while the process exits are not reported anymore
+    static bool destroyed() { return m_destroyed.load(); }
+
+    site_reporter() : m_cv(new std::condition_variable()) { m_instance = this; }
+    ~site_reporter()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_cv->notify_one();
+        if (m_thread)
+            m_thread->join();
+        m_instance = nullptr;
+        m_destroyed = true;
+        report(true);
+    }
+
+    void add(const pending_site & pending, int64_t due)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sites.push_back({ pending, due });
+        if (!m_thread)
+            m_thread.reset(new std::thread(&site_reporter::run, this));
+        m_cv->notify_one();
+    }
+
+    // Report the sites due by now, or all of them
+    void report(bool all)
+    {
+        std::vector<entry> due;
+        {
+            const int64_t t = now();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = std::stable_partition(m_sites.begin(), m_sites.end(),
+                                            [&](const entry & e) { return !all && e.due > t; });
+            due.assign(it, m_sites.end());
+            m_sites.erase(it, m_sites.end());
+        }
+        for (const entry & e : due) {
+            _simplelog_site & site = *e.pending.site;
+            __atomic_store_n(&site.pending, 0, __ATOMIC_RELAXED);
+            // Pairs with the fence of defer: a log suppressed from now on either is counted below,
+            // or defers the site again
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            const uint64_t repeats = __atomic_exchange_n(&site.repeats, 0, __ATOMIC_RELAXED);
+            const uint64_t dropped = __atomic_exchange_n(&site.dropped, 0, __ATOMIC_RELAXED);
+            e.pending.owner->writeCounts(e.pending.level, e.pending.filename, e.pending.funcname,
+                                         e.pending.line, repeats, dropped);
+        }
+    }
+
+#ifndef _WIN32
+    void prepareFork() { m_mutex.lock(); }
+    void parentFork() { m_mutex.unlock(); }
+    void childFork()
+    {
+        // Like the asynchronous writer thread, the reporter thread of the parent and the waiters
+        // of its condition variable don't exist in the child, and are leaked on purpose
+        if (m_thread) {
+            m_cv.release();
+            m_thread.release();
+            m_cv.reset(new std::condition_variable());
+            m_thread.reset(new std::thread(&site_reporter::run, this));
+        }
+        m_mutex.unlock();
+    }
+#endif
+
+private:
+    struct entry
+    {
+        pending_site pending;
+        int64_t due;
+    };
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stop) {
+            if (m_sites.empty()) {
+                m_cv->wait(lock);
+            } else {
+                int64_t due = m_sites.front().due;
+                for (const entry & e : m_sites)
+                    due = std::min(due, e.due);
+                m_cv->wait_for(lock, std::chrono::nanoseconds(due - now()));
+            }
+            if (m_stop)
+                break;
+            lock.unlock();
+            report(false);
+            lock.lock();
+        }
+    }
+
+    std::mutex m_mutex;
+    std::unique_ptr<std::condition_variable> m_cv;
+    std::unique_ptr<std::thread> m_thread;
+    std::vector<entry> m_sites;
+    bool m_stop = false;
+
+    static std::atomic<site_reporter *> m_instance;
+    static std::atomic<bool> m_destroyed;
+};
+std::atomic<site_reporter *> site_reporter::m_instance(nullptr);
+std::atomic<bool> site_reporter::m_destroyed(false);
+} // namespace
+
+bool call_site::admit(_simplelog_site & site, const rate_limit & limit)
+{
+    if (limit.intervalNs == 0)
+        return true;
+    // Generic cell rate algorithm: next is the time at which the bucket would be full again
+    const int64_t t = now();
+    long long next = __atomic_load_n(&site.next, __ATOMIC_RELAXED);
+    while (true) {
+        const int64_t from = next > t ? next : t;
+        if (from - t > limit.toleranceNs) {
+            __atomic_fetch_add(&site.dropped, 1, __ATOMIC_RELAXED);
+            return false;
+        }
+        if (__atomic_compare_exchange_n(&site.next, &next, from + limit.intervalNs, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return true;
+    }
+}
+
+bool call_site::unfold(_simplelog_site & site, string_view msg, uint64_t & repeats,
+                       uint64_t & dropped)
+{
+    const uint64_t h = hash(msg);
+    const int64_t t = now();
+    if (__atomic_exchange_n(&site.hash, h, __ATOMIC_RELAXED) == h
+        && t < __atomic_load_n(&site.until, __ATOMIC_RELAXED)) {
+        __atomic_fetch_add(&site.repeats, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    __atomic_store_n(&site.until, t + foldWindowNs, __ATOMIC_RELAXED);
+    repeats = __atomic_exchange_n(&site.repeats, 0, __ATOMIC_RELAXED);
+    dropped = __atomic_exchange_n(&site.dropped, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
+void call_site::defer(const pending_site & pending)
+{
+    _simplelog_site & site = *pending.site;
+    // Pairs with the fence of the reporter
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&site.pending, __ATOMIC_RELAXED)
+        || __atomic_exchange_n(&site.pending, 1, __ATOMIC_RELAXED) || site_reporter::destroyed())
+        return;
+    // Duplicates are reported once the folding window of the site expired, dropped logs at most
+    // once a second
+    const int64_t t = now();
+    const int64_t until = __atomic_load_n(&site.until, __ATOMIC_RELAXED);
+    site_reporter::get().add(pending, until > t ? until : t + foldWindowNs);
+}
+
+void call_site::reportPending()
+{
+    site_reporter * reporter = site_reporter::instance();
+    if (reporter)
+        reporter->report(true);
+}
+
+#ifndef _WIN32
+void call_site::prepareFork()
+{
+    site_reporter * reporter = site_reporter::instance();
+    if (reporter)
+        reporter->prepareFork();
+}
+
+void call_site::parentFork()
+{
+    site_reporter * reporter = site_reporter::instance();
+    if (reporter)
+        reporter->parentFork();
+}
+
+void call_site::childFork()
+{
+    site_reporter * reporter = site_reporter::instance();
+    if (reporter)
+        reporter->childFork();
+}
+#endif
+
+void call_site::render(memory_buffer & buffer, const char * msg, va_list args)
+{
+    va_list copy;
+    va_copy(copy, args);
+    int len = vsnprintf(buffer.data(), buffer.capacity(), msg, copy);
+    va_end(copy);
+    if (len < 0)
+        return;
+    if (static_cast<size_t>(len) >= buffer.capacity()) {
+        buffer.reserve(len + 1);
+        vsnprintf(buffer.data(), len + 1, msg, args);
+    }
+    buffer.resize(len);
+}
+
+void module::writeSite(_simplelog_site & site, bool fold, unsigned every, log_level level,
+                       const char * filename, const char * funcname, int line,
+                       memory_buffer & msg, stage_timer & timer)
+{
+    uint64_t repeats = 0, dropped = 0;
+    if (fold && !call_site::unfold(site, string_view(msg.data(), msg.size()), repeats, dropped))
+        return call_site::defer({ &site, this, level, filename, funcname, line });
+    writeCounts(level, filename, funcname, line, repeats, dropped);
+    if (every > 1)
+        fmt::format_to(fmt::appender(msg), FMT_COMPILE(" [sampled 1/{}]"), every);
+    m_engine->writeFormatted(m_tag.c_str(), level, filename, funcname, line,
+                             string_view(msg.data(), msg.size()), timer);
+}
+
+void module::writeCounts(log_level level, const char * filename, const char * funcname, int line,
+                         uint64_t repeats, uint64_t dropped)
+{
+    if (repeats)
+        m_engine->write(m_tag.c_str(), level, filename, funcname, line,
+                        FMT_COMPILE("Previous message repeated {} times"), repeats);
+    if (dropped)
+        m_engine->write(m_tag.c_str(), level, filename, funcname, line,
+                        FMT_COMPILE("{} logs dropped by rate limit"), dropped);
+}
@@ -5,7 +5,9 @@
 #include "config.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include "config_parser.h"
+#include "load_shedding.h"
 
 using namespace simplelog;
 
@@ -18,11 +20,28 @@ const unordered_casemap<log_level> config::m_logLevelNames = {
     { "4", log_level::debug },   { "d", log_level::debug },   { "debug", log_level::debug },
     { "5", log_level::verbose }, { "v", log_level::verbose }, { "verbose", log_level::verbose },
 };
+const unordered_casemap<timestamp_mode> config::m_timestampModeNames = {
+    { "local", timestamp_mode::local },
+    { "utc", timestamp_mode::utc },
+    { "epoch", timestamp_mode::epoch },
+};
+const unordered_casemap<timestamp_precision> config::m_timestampPrecisionNames = {
+    { "ms", timestamp_precision::ms },
+    { "us", timestamp_precision::us },
+    { "ns", timestamp_precision::ns },
+};
 
 config::config() :
+    m_version(0),
     m_defaultLoggers(true),
     m_async(false),
     m_formatter("Default"),
+    m_timestampMode(timestamp_mode::local),
+    m_timestampPrecision(timestamp_precision::ms),
+    m_siteProfiling(false),
+    m_siteSummary(0),
+    m_stageTiming(0),
+    m_crashHandler(false),
 #ifdef __ANDROID__
     m_loggers({ { "Android", logger{ "Android", "" } } })
 #else
@@ -36,9 +55,18 @@ config & config::get()
     return c;
 }
 
+void config::setDefaultLevel(log_level level)
+{
+    m_tags[m_defaultTag].level = level;
+    compileTags();
+    m_version++;
+}
+
 void config::setDefaultLoggers(const std::string & loggers_names)
 {
     m_tags[m_defaultTag].loggers = splitLoggers(loggers_names);
+    compileTags();
+    m_version++;
 }
 
 void config::checkTags()
@@ -53,6 +81,14 @@ void config::checkTags()
         if (tls.empty() && !m_loggers.empty())
             tls.emplace_back(m_loggers.begin()->first);
     }
+    compileTags();
+}
+
+void config::compileTags()
+{
+    m_tagMatcher.clear();
+    for (const auto & t : m_tags)
+        m_tagMatcher.add(t.first, &t.second);
 }
 
 void config::addLogger(const std::string & name, const std::string & type, const std::string & address)
@@ -64,6 +100,7 @@ void config::addLogger(const std::string & name, const std::string & type, const
     }
     m_loggers[name] = logger{ type, address };
     checkTags();
+    m_version++;
 }
 
 void config::update(std::unique_ptr<std::istream> data)
@@ -89,6 +126,15 @@ void config::update(std::unique_ptr<std::istream> data)
             break;
         }
     }
+    // Rate limits section
+    for (const auto & s : { "ratelimit", "ratelimits", "rate_limit", "rate_limits" }) {
+        section = sections.find(s);
+        if (section != sections.end()) {
+            parseRateLimits(section->second);
+            break;
+        }
+    }
+    m_version++;
 }
 
 void config::parseGeneral(const config_parser::entries & e)
@@ -99,6 +145,36 @@ void config::parseGeneral(const config_parser::entries & e)
     entry = e.find("formatter");
     if (entry != e.end())
         m_formatter = entry->second;
+    // Unknown values keep the current setting
+    entry = e.find("timestamp");
+    if (entry != e.end()) {
+        auto mode = m_timestampModeNames.find(entry->second);
+        if (mode != m_timestampModeNames.end())
+            m_timestampMode = mode->second;
+    }
+    entry = e.find("precision");
+    if (entry != e.end()) {
+        auto precision = m_timestampPrecisionNames.find(entry->second);
+        if (precision != m_timestampPrecisionNames.end())
+            m_timestampPrecision = precision->second;
+    }
+    entry = e.find("site_profiling");
+    if (entry != e.end())
+        m_siteProfiling = entry->second[0] == '1' || entry->second[0] == 'T'
+                          || entry->second[0] == 't';
+    entry = e.find("site_summary");
+    if (entry != e.end())
+        m_siteSummary = static_cast<unsigned>(strtoul(entry->second.c_str(), nullptr, 10));
+    entry = e.find("stage_timing");
+    if (entry != e.end())
+        m_stageTiming = static_cast<unsigned>(strtoul(entry->second.c_str(), nullptr, 10));
+    entry = e.find("load_shedding");
+    if (entry != e.end())
+        m_loadShedding = parseWatermarks(entry->second);
+    entry = e.find("crash_handler");
+    if (entry != e.end())
+        m_crashHandler = entry->second[0] == '1' || entry->second[0] == 'T'
+                         || entry->second[0] == 't';
 }
 
 void config::parseLoggers(const config_parser::entries & e)
@@ -130,9 +206,69 @@ void config::parseTags(const config_parser::entries & e)
         levelStr = pos == std::string::npos ? entry.second : entry.second.substr(0, pos);
         parseLevel(levelStr, t.level);
         t.loggers = splitLoggers(entry.second);
-        if (t.level != log_level::verbose || !t.loggers.empty())
+        // Sampling tokens: sample=[<level>:]<count>[/s]
+        static const std::string sampleKey = "sample=";
+        for (size_t cur = 0; cur < entry.second.size(); cur = pos + 1) {
+            pos = entry.second.find(',', cur);
+            if (pos == std::string::npos)
+                pos = entry.second.size();
+            const size_t value = cur + sampleKey.size();
+            if (entry.second.compare(cur, sampleKey.size(), sampleKey) == 0 && value <= pos)
+                parseSample(entry.second.substr(value, pos - value), t.samples);
+        }
+        if (t.level != log_level::verbose || !t.loggers.empty() || sampler::any(t.samples))
             m_tags[entry.first] = t;
     }
+    compileTags();
+}
+
+bool config::parseSample(const std::string & str, sample_rates & samples)
+{
+    std::string count = str;
+    log_level level = log_level::verbose;
+    const bool allLevels = str.find(':') == std::string::npos;
+    if (!allLevels) {
+        if (!parseLevel(str.substr(0, str.find(':')), level))
+            return false;
+        count = str.substr(str.find(':') + 1);
+    }
+    char * end = nullptr;
+    const double value = strtod(count.c_str(), &end);
+    if (end == count.c_str() || value < 1)
+        return false;
+    sample_rate rate;
+    if (std::string(end) == "/s")
+        rate.perSecond = value;
+    else if (*end == '\0')
+        rate.every = static_cast<unsigned>(value);
+    else
+        return false;
+    for (size_t i = 0; i < samples.size(); i++) {
+        if (allLevels || i == static_cast<size_t>(level))
+            samples[i] = rate;
+    }
+    return true;
+}
+
+std::vector<unsigned> config::parseWatermarks(const std::string & str)
+{
+    // Format: <percent>[,<percent>[,<percent>]], invalid percents are ignored
+    std::vector<unsigned> watermarks;
+    const char * cur = str.c_str();
+    while (*cur) {
+        char * end = nullptr;
+        const unsigned long percent = strtoul(cur, &end, 10);
+        if (end == cur)
+            end++;
+        else if (percent > 0 && percent <= 100)
+            watermarks.push_back(static_cast<unsigned>(percent));
+        cur = end;
+    }
+    // Each step sheds one more level, from the lowest watermark
+    std::sort(watermarks.begin(), watermarks.end());
+    if (watermarks.size() > load_shedding::maxSteps)
+        watermarks.resize(load_shedding::maxSteps);
+    return watermarks;
 }
 
 config::loggers_names config::splitLoggers(const std::string & loggers_str) const
@@ -172,6 +308,38 @@ void config::splitPair(const std::string & str, std::string & key, std::string &
     }
 }
 
+void config::parseRateLimits(const config_parser::entries & e)
+{
+    m_rateLimits.clear();
+    for (const auto & entry : e) {
+        rate_limit limit;
+        if (parseRateLimit(entry.second, limit))
+            m_rateLimits[entry.first] = limit;
+    }
+    m_rateLimitMatcher.clear();
+    for (const auto & l : m_rateLimits)
+        m_rateLimitMatcher.add(l.first, &l.second);
+}
+
+bool config::parseRateLimit(const std::string & str, rate_limit & limit)
+{
+    // Format: <count>[/s|/m|/h], 0 to only fold duplicates
+    char * end = nullptr;
+    const double count = strtod(str.c_str(), &end);
+    if (end == str.c_str() || count < 0)
+        return false;
+    double seconds = 1;
+    const std::string period(end);
+    if (period == "/m")
+        seconds = 60;
+    else if (period == "/h")
+        seconds = 3600;
+    else if (!period.empty() && period != "/s")
+        return false;
+    limit = rate_limit(count, seconds);
+    return true;
+}
+
 bool config::parseLevel(const std::string & level_str, log_level & level)
 {
     auto lvl = m_logLevelNames.find(level_str);
@@ -11,9 +11,12 @@
 #include <string>
 #include <vector>
 
+#include "call_site.h"
 #include "casecmp.h"
 #include "config_parser.h"
 #include "log_metadata.h"
+#include "sampler.h"
+#include "tag_matcher.h"
 
 namespace simplelog {
 
@@ -31,6 +34,7 @@ public:
     {
         log_level level;
         loggers_names loggers;
+        sample_rates samples;
         tag() : level(log_level::verbose) {}
     };
 
@@ -38,18 +42,63 @@ public:
 
     // Setters
     void update(std::unique_ptr<std::istream> data);
-    void setDefaultLevel(log_level level) { m_tags[m_defaultTag].level = level; }
+    void setDefaultLevel(log_level level);
     void setDefaultLoggers(const std::string & loggers_names);
-    void setAsync(bool async) { m_async = async; }
-    void setFormatter(const std::string & formatter) { m_formatter = formatter; }
+    void setAsync(bool async)
+    {
+        m_async = async;
+        m_version++;
+    }
+    void setFormatter(const std::string & formatter)
+    {
+        m_formatter = formatter;
+        m_version++;
+    }
+    void setTimestamp(timestamp_mode mode, timestamp_precision precision)
+    {
+        m_timestampMode = mode;
+        m_timestampPrecision = precision;
+        m_version++;
+    }
+    void setSiteProfiling(bool enabled, unsigned summaryInterval)
+    {
+        m_siteProfiling = enabled;
+        m_siteSummary = summaryInterval;
+    }
+    void setStageTiming(unsigned sampling) { m_stageTiming = sampling; }
+    void setCrashHandler(bool enabled) { m_crashHandler = enabled; }
+    void setLoadShedding(std::vector<unsigned> watermarks)
+    {
+        m_loadShedding = std::move(watermarks);
+    }
     void addLogger(const std::string & name, const std::string & type, const std::string & address);
 
     // Getters
     static const std::string & defaultTag() { return m_defaultTag; }
+    // Changed by the setters of the routing of the modules: levels, loggers, formatter, async
+    // and timestamps
+    unsigned version() const { return m_version; }
     bool async() const { return m_async; }
     const std::string & formatter() const { return m_formatter; }
+    timestamp_mode timestampMode() const { return m_timestampMode; }
+    timestamp_precision timestampPrecision() const { return m_timestampPrecision; }
+    bool siteProfiling() const { return m_siteProfiling; }
+    // Seconds between summaries of the noisiest call sites, 0 for none
+    unsigned siteSummary() const { return m_siteSummary; }
+    // Time the stages of 1 log out of stageTiming(), 0 for none
+    unsigned stageTiming() const { return m_stageTiming; }
+    bool crashHandler() const { return m_crashHandler; }
+    // Async queue fill percentages from which verbose, debug, then info logs are shed
+    const std::vector<unsigned> & loadShedding() const { return m_loadShedding; }
     const unordered_casemap<logger> & loggers() const { return m_loggers; }
     const unordered_casemap<tag> & tags() const { return m_tags; }
+    // Most specific tag configuration matching a module tag, if any
+    const tag * findTag(const std::string & name) const { return m_tagMatcher.find(name); }
+    // Most specific rate limit matching a module tag, if any
+    const rate_limit * findRateLimit(const std::string & name) const
+    {
+        return m_rateLimitMatcher.find(name);
+    }
 
     // Utility to split a string into several registered loggers
     loggers_names splitLoggers(const std::string & str) const;
@@ -62,19 +111,37 @@ private:
     void parseGeneral(const config_parser::entries & e);
     void parseLoggers(const config_parser::entries & e);
     void parseTags(const config_parser::entries & e);
+    void parseRateLimits(const config_parser::entries & e);
     void checkTags();
+    void compileTags();
 
     static void splitPair(const std::string & str, std::string & key, std::string & value);
     static bool parseLevel(const std::string & level_str, log_level & level);
+    static bool parseRateLimit(const std::string & str, rate_limit & limit);
+    static bool parseSample(const std::string & str, sample_rates & samples);
+    static std::vector<unsigned> parseWatermarks(const std::string & str);
 
+    unsigned m_version;
     bool m_defaultLoggers;
     bool m_async;
     std::string m_formatter;
+    timestamp_mode m_timestampMode;
+    timestamp_precision m_timestampPrecision;
+    bool m_siteProfiling;
+    unsigned m_siteSummary;
+    unsigned m_stageTiming;
+    std::vector<unsigned> m_loadShedding;
+    bool m_crashHandler;
     unordered_casemap<logger> m_loggers;
     unordered_casemap<tag> m_tags;
+    tag_matcher<tag> m_tagMatcher;
+    unordered_casemap<rate_limit> m_rateLimits;
+    tag_matcher<rate_limit> m_rateLimitMatcher;
 
     static const std::string m_defaultTag;
     static const unordered_casemap<log_level> m_logLevelNames;
+    static const unordered_casemap<timestamp_mode> m_timestampModeNames;
+    static const unordered_casemap<timestamp_precision> m_timestampPrecisionNames;
 };
 
 } // namespace simplelog
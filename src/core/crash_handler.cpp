@@ -0,0 +1,177 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "crash_handler.h"
+
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#ifndef _WIN32
+#include <signal.h>
+#endif
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define SIMPLELOG_BACKTRACE
+#endif
+
+#include "async_backend.h"
+#include "config.h"
+#include "logger.h"
+
+using namespace simplelog;
+
+#ifndef _WIN32
+namespace {
+const int signals[] = { SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT };
+const char * const signalNames[] = { "SIGSEGV", "SIGBUS", "SIGFPE", "SIGILL", "SIGABRT" };
+const size_t signalCount = sizeof(signals) / sizeof(signals[0]);
+struct sigaction previous[signalCount];
+bool installed = false;
+std::mutex installMutex;
+std::atomic_bool crashing(false);
+
+// Loggers written by the handler and their distinct file descriptors, taken outside of it as
+// the loggers and the asynchronous engines may change while it runs
+const size_t maxLoggers = 32;
+const size_t maxFds = 32;
+struct snapshot
+{
+    logger * loggers[maxLoggers];
+    size_t loggerCount;
+    int fds[maxFds];
+    size_t fdCount;
+};
+// Filled alternately, so that the published one is never modified by the next update
+snapshot snapshots[2];
+std::atomic<const snapshot *> current(nullptr);
+const int maxFrames = 64;
+
+// Handler stack of the installing thread only, so that its stack overflows are reported.
+// A stack overflow of another thread crashes without reaching the handler.
+char altStack[64 * 1024];
+
+snapshot * filling = nullptr;
+void addLogger(logger & l)
+{
+    snapshot & s = *filling;
+    for (size_t i = 0; i < s.loggerCount; i++) {
+        if (s.loggers[i] == &l)
+            return;
+    }
+    if (s.loggerCount < maxLoggers)
+        s.loggers[s.loggerCount++] = &l;
+    const int fd = l.crashFd();
+    if (fd < 0)
+        return;
+    for (size_t i = 0; i < s.fdCount; i++) {
+        if (s.fds[i] == fd)
+            return;
+    }
+    if (s.fdCount < maxFds)
+        s.fds[s.fdCount++] = fd;
+}
+
+// Take a new snapshot, under installMutex
+void takeSnapshot()
+{
+    filling = current.load() == &snapshots[0] ? &snapshots[1] : &snapshots[0];
+    filling->loggerCount = 0;
+    filling->fdCount = 0;
+    for (const auto & l : logger_factory::loggers())
+        addLogger(*l.second);
+    async_backend::crashLoggers(addLogger);
+    current.store(filling);
+}
+
+void writeAll(const snapshot & s, const char * str)
+{
+    for (size_t i = 0; i < s.fdCount; i++)
+        os::writeFd(s.fds[i], str, strlen(str));
+}
+
+void handle(int sig, siginfo_t *, void *)
+{
+    size_t index = 0;
+    while (index < signalCount && signals[index] != sig)
+        index++;
+    // A crash of the handler itself, or of another thread meanwhile, is only raised again
+    const snapshot * s = current.load();
+    if (s && !crashing.exchange(true)) {
+        // Data buffered by the loggers is older than the queued records
+        for (size_t i = 0; i < s->loggerCount; i++)
+            s->loggers[i]->crashFlush();
+        async_backend::crashDrain();
+
+        writeAll(*s, "FATAL: Signal ");
+        writeAll(*s, index < signalCount ? signalNames[index] : "?");
+        writeAll(*s, " received, backtrace:");
+        writeAll(*s, os::getEol());
+#ifdef SIMPLELOG_BACKTRACE
+        void * frames[maxFrames];
+        const int count = backtrace(frames, maxFrames);
+        for (size_t i = 0; i < s->fdCount; i++)
+            backtrace_symbols_fd(frames, count, s->fds[i]);
+#endif
+    }
+    // Delivered to the previous handler once this one returns
+    if (index < signalCount)
+        sigaction(sig, &previous[index], nullptr);
+    raise(sig);
+}
+} // namespace
+#endif
+
+bool crash_handler::install(bool enable)
+{
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(installMutex);
+    if (enable == installed)
+        return true;
+    if (enable) {
+        takeSnapshot();
+#ifdef SIMPLELOG_BACKTRACE
+        // The unwinder is loaded on the first backtrace, which allocates
+        void * frame;
+        backtrace(&frame, 1);
+#endif
+        stack_t stack;
+        if (sigaltstack(nullptr, &stack) == 0 && (stack.ss_flags & SS_DISABLE)) {
+            stack.ss_sp = altStack;
+            stack.ss_size = sizeof(altStack);
+            stack.ss_flags = 0;
+            sigaltstack(&stack, nullptr);
+        }
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_sigaction = handle;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (size_t i = 0; i < signalCount; i++)
+            sigaction(signals[i], &action, &previous[i]);
+    } else {
+        for (size_t i = 0; i < signalCount; i++)
+            sigaction(signals[i], &previous[i], nullptr);
+        current = nullptr;
+    }
+    installed = enable;
+    return true;
+#else
+    return !enable;
+#endif
+}
+
+void crash_handler::update()
+{
+#ifndef _WIN32
+    std::lock_guard<std::mutex> lock(installMutex);
+    if (installed)
+        takeSnapshot();
+#endif
+}
+
+extern "C" void _simplelog_crash_handler(int enable)
+{
+    config::get().setCrashHandler(enable != 0);
+    crash_handler::install(enable != 0);
+}
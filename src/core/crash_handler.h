@@ -0,0 +1,28 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_CRASH_HANDLER
+#define SIMPLELOG_CRASH_HANDLER
+
+namespace simplelog {
+
+// Opt-in handler of fatal signals (SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT).
+// The handler writes the data buffered by the loggers, the records still queued by the
+// asynchronous backend, then a fatal line with a raw backtrace, only through async-signal-safe
+// write(2) calls. The signal is then raised again to its previous handler.
+// The loggers written are a snapshot taken at install time, and on each update().
+// The alternate signal stack, needed to report stack overflows, is only set on the installing
+// thread. Not supported on Windows.
+class crash_handler
+{
+public:
+    // Install the handler, or restore the previous ones. Return false if not supported.
+    static bool install(bool enable);
+    // Snapshot again the loggers, once opened, or once asynchronous engines attach or detach
+    static void update();
+};
+
+} // namespace simplelog
+
+#endif
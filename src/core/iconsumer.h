@@ -5,6 +5,7 @@
 #ifndef SIMPLELOG_ICONSUMER
 #define SIMPLELOG_ICONSUMER
 
+#include <cstdint>
 #include <stdio.h>
 #include "log_metadata.h"
 
@@ -14,8 +15,11 @@ class iconsumer
 {
 public:
     virtual ~iconsumer() = default;
-    virtual void consume(log_level level, const char * msg, size_t len) = 0;
+    // Return false if the log is dropped
+    virtual bool consume(log_level level, const char * msg, size_t len) = 0;
     virtual void flush() = 0;
+    // Logs queued and not written yet, and the maximum so far
+    virtual void queueDepth(uint64_t & current, uint64_t & max) const { current = max = 0; }
 };
 
 } // namespace simplelog
@@ -0,0 +1,60 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "load_shedding.h"
+
+#include <algorithm>
+
+#include "config.h"
+#include "logger.h"
+
+using namespace simplelog;
+
+std::atomic<int> load_shedding::m_level(log_level::verbose);
+std::atomic<unsigned> load_shedding::m_watermarks[load_shedding::maxSteps];
+
+void load_shedding::setWatermarks(const std::vector<unsigned> & percents)
+{
+    for (size_t i = 0; i < maxSteps; i++)
+        m_watermarks[i] = i < percents.size() ? percents[i] : 0;
+    if (percents.empty())
+        m_level = log_level::verbose;
+}
+
+bool load_shedding::update(size_t queued, size_t maxQueued)
+{
+    // Steps are entered at their watermark, and only left below half of it.
+    // Called on each push, so fill percentages are compared without dividing.
+    size_t up = 0, down = 0;
+    for (size_t i = 0; i < maxSteps; i++) {
+        const unsigned watermark = m_watermarks[i].load(std::memory_order_relaxed);
+        if (watermark == 0)
+            break;
+        up += queued * 100 >= watermark * maxQueued;
+        down += queued * 200 >= watermark * maxQueued;
+    }
+    const int level = m_level.load(std::memory_order_relaxed);
+    const size_t step = static_cast<size_t>(log_level::verbose - level);
+    size_t next = step;
+    if (up > step)
+        next = up;
+    else if (down < step)
+        next = down;
+    if (next == step)
+        return false;
+    m_level.store(log_level::verbose - static_cast<int>(next), std::memory_order_relaxed);
+    return true;
+}
+
+extern "C" void _simplelog_load_shedding(unsigned verbose, unsigned debug, unsigned info)
+{
+    std::vector<unsigned> watermarks;
+    for (unsigned percent : { verbose, debug, info }) {
+        if (percent > 0 && percent <= 100)
+            watermarks.push_back(percent);
+    }
+    std::sort(watermarks.begin(), watermarks.end());
+    config::get().setLoadShedding(watermarks);
+    load_shedding::setWatermarks(watermarks);
+}
@@ -4,14 +4,22 @@
  */
 #include "logger.h"
 
+#include <algorithm>
 #include <fstream>
 #include <memory>
 #include <mutex>
 #include <stdexcept>
-#include <unordered_set>
+#include <tuple>
+#include <unordered_map>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
+#include "async_backend.h"
 #include "config.h"
+#include "crash_handler.h"
 #include "logger_engine.h"
+#include "thread_identity.h"
 
 using namespace simplelog;
 
@@ -21,9 +29,58 @@ std::mutex & engineMutex()
     static std::mutex mutex;
     return mutex;
 }
-std::unordered_set<std::shared_ptr<logger>> & loggers()
+// Engines are shared between all modules with the same routing
+struct engine_key
 {
-    static std::unordered_set<std::shared_ptr<logger>> list;
+    log_level level;
+    std::vector<logger *> loggers;
+    std::string formatter;
+    bool async;
+    timestamp_mode timestamp;
+    timestamp_precision precision;
+
+    bool operator==(const engine_key & other) const
+    {
+        return std::tie(level, loggers, formatter, async, timestamp, precision)
+               == std::tie(other.level, other.loggers, other.formatter, other.async,
+                           other.timestamp, other.precision);
+    }
+};
+struct engine_key_hash
+{
+    size_t operator()(const engine_key & key) const
+    {
+        size_t hash = icasehash()(key.formatter);
+        hash = 33 * hash + std::hash<int>()(key.level);
+        hash = 33 * hash + std::hash<bool>()(key.async);
+        hash = 33 * hash + static_cast<size_t>(key.timestamp);
+        hash = 33 * hash + static_cast<size_t>(key.precision);
+        for (auto l : key.loggers)
+            hash = 33 * hash + std::hash<logger *>()(l);
+        return hash;
+    }
+};
+std::unordered_map<engine_key, std::shared_ptr<logger_engine>, engine_key_hash> & engines()
+{
+    static std::unordered_map<engine_key, std::shared_ptr<logger_engine>, engine_key_hash> map;
+    return map;
+}
+// Module declared with the configuration version it was created from
+struct declared_module
+{
+    unsigned version;
+    std::unique_ptr<module> handle;
+};
+// Modules by tag, then by forced loggers names
+unordered_casemap<unordered_casemap<declared_module>> & modules()
+{
+    static unordered_casemap<unordered_casemap<declared_module>> map;
+    return map;
+}
+// Modules replaced after a configuration change, never freed as their handles may still be used
+std::vector<std::unique_ptr<module>> & replacedModules()
+{
+    static std::vector<std::unique_ptr<module>> list;
     return list;
 }
 void initConfig()
@@ -44,6 +101,23 @@ void initConfig()
         initialized = true;
     }
 }
+// Description of an engine routing, ie. "info Default async [Console,FileTmp]"
+std::string engineName(const engine_key & key)
+{
+    static const char * levels[] = { "disabled", "panic", "error", "warning",
+                                     "info",     "debug", "verbose" };
+    std::string name = levels[key.level];
+    name += " " + key.formatter + (key.async ? " async [" : " sync [");
+    bool first = true;
+    for (const auto & l : logger_factory::loggers()) {
+        if (std::find(key.loggers.begin(), key.loggers.end(), l.second.get())
+            == key.loggers.end())
+            continue;
+        name += (first ? "" : ",") + l.first;
+        first = false;
+    }
+    return name + "]";
+}
 void initLoggers()
 {
     static bool initialized = false;
@@ -54,6 +128,45 @@ void initLoggers()
         initialized = true;
     }
 }
+
+#ifndef _WIN32
+// Nothing may be logging while forking: a lock held by another thread, or a half written record,
+// would never be released in the child, where only the forking thread exists
+void prepareFork()
+{
+    engineMutex().lock();
+    for (const auto & e : engines())
+        e.second->lockWrites();
+    async_backend::prepareFork();
+    call_site::prepareFork();
+    // Data buffered by the loggers would be written by both processes
+    for (const auto & l : logger_factory::loggers())
+        l.second->flush();
+}
+void parentFork()
+{
+    call_site::parentFork();
+    async_backend::parentFork();
+    for (const auto & e : engines())
+        e.second->unlockWrites();
+    engineMutex().unlock();
+}
+void childFork()
+{
+    thread_identity::reset();
+    async_backend::childFork();
+    call_site::childFork();
+    for (const auto & l : logger_factory::loggers())
+        l.second->afterFork();
+    for (const auto & e : engines())
+        e.second->unlockWrites();
+    engineMutex().unlock();
+}
+struct fork_handlers
+{
+    fork_handlers() { pthread_atfork(prepareFork, parentFork, childFork); }
+} forkHandlers;
+#endif
 } // namespace
 
 extern "C" void _simplelog_config_path(const char * path)
@@ -92,37 +205,82 @@ extern "C" void _simplelog_default_log_level(int level)
     config::get().setDefaultLevel(log_level(level));
 }
 
-extern "C" void * _simplelog_create(const char * tag, const char * loggers_names)
+namespace {
+// Must be called with engineMutex() locked
+module * createModule(const char * tag, const char * loggers_names)
 {
     if (!tag)
         throw std::runtime_error("Invalid log tag");
-    std::lock_guard<std::mutex> lock(engineMutex());
     initConfig();
-    log_level level = log_level::verbose;
-    // Init formatter
-    auto f = formatter_factory::get(config::get().formatter());
-    if (f == nullptr)
-        f = formatter_factory::get();
+    const config & c = config::get();
+    // Already declared module, unless the configuration changed since
+    std::string names = loggers_names == nullptr ? std::string() : loggers_names;
+    auto & declared = modules()[tag][names];
+    if (declared.handle) {
+        if (declared.version == c.version())
+            return declared.handle.get();
+        replacedModules().push_back(std::move(declared.handle));
+    }
+
+    site_profiler::configure(c.siteProfiling(), c.siteSummary());
+    stage_timing::setSampling(c.stageTiming());
+    load_shedding::setWatermarks(c.loadShedding());
+    crash_handler::install(c.crashHandler());
     // Init loggers
     initLoggers();
-    std::string names = loggers_names == nullptr ? std::string() : loggers_names;
-    auto ls = logger_factory::get(tag, config::get().splitLoggers(names));
+    auto ls = logger_factory::get(tag, c.splitLoggers(names));
     // Tag configuration
-    auto ts = config::get().tags();
-    auto t = ts.find(std::string(tag));
-    if (t == ts.end())
-        t = ts.find(config::defaultTag());
-    if (t != ts.end()) {
-        if (!t->second.loggers.empty())
-            ls = logger_factory::get(tag, t->second.loggers);
-        level = t->second.level;
-    }
-    // Create engine
-    auto engine = std::make_shared<logger_engine>(tag, level, f, std::move(ls));
-    if (config::get().async())
-        engine->setAsync();
-    loggers().insert(engine);
-    return engine.get();
+    log_level level = log_level::verbose;
+    auto t = c.findTag(tag);
+    if (t) {
+        if (!t->loggers.empty())
+            ls = logger_factory::get(tag, t->loggers);
+        level = t->level;
+    }
+    // Look for an engine with the same routing
+    engine_key key{
+        level, {}, c.formatter(), c.async(), c.timestampMode(), c.timestampPrecision()
+    };
+    for (const auto & l : ls)
+        key.loggers.push_back(l.get());
+    std::sort(key.loggers.begin(), key.loggers.end());
+    auto & engine = engines()[key];
+    if (!engine) {
+        auto f = formatter_factory::get(c.formatter());
+        if (f == nullptr)
+            f = formatter_factory::get();
+        engine = std::make_shared<logger_engine>(level, f, std::move(ls), engineName(key));
+        engine->setTimestamp(c.timestampMode(), c.timestampPrecision());
+        if (c.async())
+            engine->setAsync();
+        crash_handler::update();
+    }
+    declared.version = c.version();
+    declared.handle = std::make_unique<module>(tag, level, engine, c.findRateLimit(tag),
+                                               t ? &t->samples : nullptr);
+    return declared.handle.get();
+}
+} // namespace
+
+extern "C" void * _simplelog_create(const char * tag, const char * loggers_names)
+{
+    std::lock_guard<std::mutex> lock(engineMutex());
+    return createModule(tag, loggers_names);
+}
+
+extern "C" void * _simplelog_create_once(void ** module, const char * tag,
+                                         const char * loggers_names)
+{
+    if (!module)
+        return _simplelog_create(tag, loggers_names);
+    std::lock_guard<std::mutex> lock(engineMutex());
+    // Another thread may have initialized the module while waiting for the lock
+    void * m = _SLOG_LOAD_ACQUIRE(module);
+    if (m == nullptr) {
+        m = createModule(tag, loggers_names);
+        _SLOG_STORE_RELEASE(module, m);
+    }
+    return m;
 }
 
 extern "C" void _simplelog_log(void * thiz, int prio, const char * filename, const char * funcname,
@@ -132,15 +290,155 @@ extern "C" void _simplelog_log(void * thiz, int prio, const char * filename, con
         return;
     va_list args;
     va_start(args, msg);
-    reinterpret_cast<logger *>(thiz)->log(log_level(prio), filename, funcname, line, msg, args);
+    reinterpret_cast<module *>(thiz)->log(log_level(prio), filename, funcname, line, msg, args);
     va_end(args);
 }
 
+extern "C" void _simplelog_logf(void * thiz, void ** format_cache, int prio,
+                                const char * filename, const char * funcname, int line,
+                                const char * msg, ...)
+{
+    if (!thiz || !filename || !funcname || !msg)
+        return;
+    auto m = reinterpret_cast<module *>(thiz);
+    const printf_format * format = format_cache ? printf_format::get(format_cache, msg) : nullptr;
+    va_list args;
+    va_start(args, msg);
+    if (format)
+        m->log(log_level(prio), filename, funcname, line, *format, args);
+    else
+        m->log(log_level(prio), filename, funcname, line, msg, args);
+    va_end(args);
+}
+
+extern "C" void _simplelog_log_str(void * thiz, int prio, const char * filename,
+                                   const char * funcname, int line, const char * msg, size_t len)
+{
+    if (!thiz || !filename || !funcname || !msg)
+        return;
+    reinterpret_cast<module *>(thiz)->logFormatted(log_level(prio), filename, funcname, line,
+                                                   string_view(msg, len));
+}
+
+extern "C" void _simplelog_logf_site(void * thiz, struct _simplelog_site * site,
+                                     double per_second, void ** format_cache, int prio,
+                                     const char * filename, const char * funcname, int line,
+                                     const char * msg, ...)
+{
+    if (!thiz || !site || !filename || !funcname || !msg)
+        return;
+    auto m = reinterpret_cast<module *>(thiz);
+    const printf_format * format = format_cache ? printf_format::get(format_cache, msg) : nullptr;
+    va_list args;
+    va_start(args, msg);
+    if (per_second >= 0) {
+        const rate_limit limit(per_second, 1);
+        if (format)
+            m->logLimited(*site, limit, log_level(prio), filename, funcname, line, *format, args);
+        else
+            m->logLimited(*site, limit, log_level(prio), filename, funcname, line, msg, args);
+    } else if (format) {
+        m->log(*site, log_level(prio), filename, funcname, line, *format, args);
+    } else {
+        m->log(*site, log_level(prio), filename, funcname, line, msg, args);
+    }
+    va_end(args);
+}
+
+extern "C" void _simplelog_log_str_site(void * thiz, struct _simplelog_site * site, int prio,
+                                        const char * filename, const char * funcname, int line,
+                                        const char * msg, size_t len)
+{
+    if (!thiz || !site || !filename || !funcname || !msg)
+        return;
+    reinterpret_cast<module *>(thiz)->logFormatted(*site, log_level(prio), filename, funcname,
+                                                   line, string_view(msg, len));
+}
+
 extern "C" void _simplelog_flush(void * thiz)
 {
     if (thiz == nullptr)
         return;
-    reinterpret_cast<logger *>(thiz)->flush();
+    reinterpret_cast<module *>(thiz)->flush();
+}
+
+extern "C" void _simplelog_flush_all()
+{
+    call_site::reportPending();
+    std::vector<std::shared_ptr<logger_engine>> all;
+    {
+        std::lock_guard<std::mutex> lock(engineMutex());
+        for (const auto & e : engines())
+            all.push_back(e.second);
+    }
+    for (const auto & e : all)
+        static_cast<logger &>(*e).flush();
+}
+
+extern "C" void _simplelog_metrics(void (*callback)(const struct simplelog_metrics * metrics,
+                                                    void * ctx),
+                                   void * ctx)
+{
+    if (!callback)
+        return;
+    // Taken first, so that the callback can log (and declare modules)
+    std::vector<std::pair<std::string, simplelog_metrics>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(engineMutex());
+        for (const auto & e : engines()) {
+            const engine_metrics & em = e.second->metrics();
+            simplelog_metrics m = {};
+            m.engine = 1;
+            m.records = em.records.get();
+            m.bytes = em.bytes.get();
+            m.drops = em.drops.get();
+            m.flushes = em.flushes.get();
+            uint64_t depth, maxDepth;
+            e.second->queueDepth(depth, maxDepth);
+            m.queue_depth = depth;
+            m.queue_max_depth = maxDepth;
+            snapshot.emplace_back(e.second->name(), m);
+        }
+        for (const auto & l : logger_factory::loggers()) {
+            const sink_metrics & sm = l.second->sinkMetrics();
+            simplelog_metrics m = {};
+            m.records = sm.records.get();
+            m.bytes = sm.bytes.get();
+            m.flushes = sm.flushes.get();
+            m.write_samples = sm.writeSamples.get();
+            m.write_total_ns = sm.writeTotalNs.get();
+            m.write_max_ns = sm.writeMaxNs.get();
+            snapshot.emplace_back(l.first, m);
+        }
+    }
+    for (auto & s : snapshot) {
+        s.second.name = s.first.c_str();
+        callback(&s.second, ctx);
+    }
+}
+
+void logger::writeRaw(log_level level, const char * msg, size_t len)
+{
+    // Only a sample of writes is timed, to keep clock reads out of most of them
+    if (m_sinkMetrics.records.add() % sink_metrics::latencySampling == 0) {
+        auto begin = std::chrono::steady_clock::now();
+        logRaw(level, msg, len);
+        auto end = std::chrono::steady_clock::now();
+        const uint64_t ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+        m_sinkMetrics.writeSamples.add();
+        m_sinkMetrics.writeTotalNs.add(ns);
+        m_sinkMetrics.writeMaxNs.max(ns);
+    } else {
+        logRaw(level, msg, len);
+    }
+    m_sinkMetrics.bytes.add(len);
+}
+
+void logger::flushRaw()
+{
+    m_sinkMetrics.flushes.add();
+    flush();
 }
 
 logger_factory::logger_factory(const std::string & type) { factories()[type] = this; }
@@ -9,16 +9,17 @@
 
 using namespace simplelog;
 
-logger_engine::logger_engine(const std::string & tag, log_level level,
-                             const std::shared_ptr<iformatter> & f,
-                             std::vector<std::shared_ptr<logger>> loggers) :
-    logger(tag, level, f),
+logger_engine::logger_engine(log_level level, const std::shared_ptr<iformatter> & f,
+                             std::vector<std::shared_ptr<logger>> loggers, std::string name) :
+    logger(std::string(), level, f),
+    m_name(std::move(name)),
     m_loggers(std::move(loggers)),
     m_consumer(std::make_shared<sync_consumer>(m_loggers))
 {}
 
 void logger_engine::setAsync(bool async)
 {
+    m_async = async;
     if (async)
         m_consumer = std::make_shared<async_consumer>(m_loggers);
     else
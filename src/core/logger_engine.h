@@ -13,17 +13,36 @@ namespace simplelog {
 class logger_engine : public logger
 {
 public:
-    logger_engine(const std::string & tag, log_level level, const std::shared_ptr<iformatter> & f,
-                  std::vector<std::shared_ptr<logger>> loggers);
+    logger_engine(log_level level, const std::shared_ptr<iformatter> & f,
+                  std::vector<std::shared_ptr<logger>> loggers, std::string name = std::string());
     void setAsync(bool async = true);
 
+    // Description of the engine routing, for metrics
+    const std::string & name() const { return m_name; }
+    const engine_metrics & metrics() const { return m_metrics; }
+    void queueDepth(uint64_t & current, uint64_t & max) const
+    {
+        m_consumer->queueDepth(current, max);
+    }
+
 private:
     virtual void logRaw(log_level level, const char * msg, size_t len) override final
     {
-        m_consumer->consume(level, msg, len);
+        if (m_consumer->consume(level, msg, len)) {
+            m_metrics.records.add();
+            m_metrics.bytes.add(len);
+        } else {
+            m_metrics.drops.add();
+        }
+    }
+    virtual void flush() override final
+    {
+        m_metrics.flushes.add();
+        m_consumer->flush();
     }
-    virtual void flush() override final { m_consumer->flush(); }
 
+    const std::string m_name;
+    engine_metrics m_metrics;
     std::vector<std::shared_ptr<logger>> m_loggers;
     std::shared_ptr<iconsumer> m_consumer;
 };
@@ -0,0 +1,327 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "printf_format.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#include "logger.h"
+
+using namespace simplelog;
+
+namespace {
+// Cached for call sites whose format can't be compiled, so that it's only tried once
+char uncompilable;
+
+std::mutex & formatsMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+template<unsigned Shift, typename T>
+void appendBase(memory_buffer & buffer, T value, const char * chars)
+{
+    using U = typename std::make_unsigned<T>::type;
+    U u = static_cast<U>(value);
+    char digits[sizeof(U) * 3];
+    char * end = digits + sizeof(digits);
+    char * p = end;
+    do {
+        *--p = chars[u & ((1u << Shift) - 1)];
+        u >>= Shift;
+    } while (u);
+    buffer.append(p, end);
+}
+} // namespace
+
+const printf_format * printf_format::get(void ** cache, const char * format)
+{
+    void * c = _SLOG_LOAD_ACQUIRE(cache);
+    if (c == nullptr) {
+        std::lock_guard<std::mutex> lock(formatsMutex());
+        c = _SLOG_LOAD_ACQUIRE(cache);
+        if (c == nullptr) {
+            // Compiled formats live as long as their call sites, so they are never released.
+            // Without memory, the call site is formatted by vsnprintf rather than aborting.
+            c = &uncompilable;
+            if (void * mem = memory::tryAllocate(sizeof(printf_format))) {
+                printf_format * f = nullptr;
+                try {
+                    f = new (mem) printf_format(format);
+                    if (f->compile())
+                        c = f;
+                } catch (const std::bad_alloc &) {
+                }
+                if (c != f) {
+                    if (f)
+                        f->~printf_format();
+                    memory::release(mem);
+                }
+            }
+            _SLOG_STORE_RELEASE(cache, c);
+        }
+    }
+    if (c == &uncompilable)
+        return nullptr;
+    auto f = static_cast<const printf_format *>(c);
+    // Guard against a call site whose format isn't the same literal on every call
+    return f->m_format == format ? f : nullptr;
+}
+
+printf_format::printf_format(const char * format) : m_format(format), m_text(format) {}
+
+bool printf_format::compile()
+{
+    const char * f = m_format;
+    size_t literal = 0;
+    size_t i = 0;
+    auto addLiteral = [this](size_t begin, size_t end) {
+        if (end > begin)
+            m_conversions.push_back({ arg_type::none, false, 0, true, 0, -1, begin, end - begin });
+    };
+    while (f[i]) {
+        if (f[i] != '%') {
+            i++;
+            continue;
+        }
+        addLiteral(literal, i);
+        const size_t begin = i++;
+        if (f[i] == '%') {
+            addLiteral(i, i + 1);
+            literal = ++i;
+            continue;
+        }
+
+        bool flags = false;
+        while (f[i] && strchr("-+ #0", f[i])) {
+            flags = true;
+            i++;
+        }
+        bool width = false;
+        while (isdigit(static_cast<unsigned char>(f[i]))) {
+            width = true;
+            i++;
+        }
+        int precision = -1;
+        if (f[i] == '.') {
+            precision = 0;
+            while (isdigit(static_cast<unsigned char>(f[++i])))
+                precision = precision * 10 + (f[i] - '0');
+        }
+        // Arguments taken from the list in another order than the conversions
+        if (f[i] == '*' || f[i] == '$')
+            return false;
+
+        char length = 0;
+        switch (f[i]) {
+            case 'h':
+            case 'l':
+                length = f[i++];
+                if (f[i] == length) {
+                    length = length == 'h' ? 'H' : 'q';
+                    i++;
+                }
+                break;
+            case 'q':
+            case 'j':
+            case 'z':
+            case 't':
+            case 'L': length = f[i++]; break;
+        }
+
+        conversion c{ arg_type::int_, false, 0, !flags && !width && precision < 0, f[i++], precision,
+                      0, 0 };
+        switch (c.conv) {
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X': c.isUnsigned = true; // fallthrough
+            case 'd':
+            case 'i':
+                switch (length) {
+                    case 'H': c.narrow = 1; break;
+                    case 'h': c.narrow = 2; break;
+                    case 'l': c.arg = arg_type::long_; break;
+                    case 'q': c.arg = arg_type::longlong_; break;
+                    case 'j': c.arg = arg_type::intmax_; break;
+                    case 'z': c.arg = arg_type::size_; break;
+                    case 't': c.arg = arg_type::ptrdiff_; break;
+                    case 'L': return false;
+                }
+                break;
+            case 'c':
+                if (length)
+                    return false;
+                break;
+            case 's':
+                if (length)
+                    return false;
+                c.arg = arg_type::string_;
+                c.simple = !flags && !width;
+                break;
+            case 'p':
+                if (length)
+                    return false;
+                c.arg = arg_type::pointer_;
+                c.simple = false;
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if (length && length != 'l' && length != 'L')
+                    return false;
+                c.arg = length == 'L' ? arg_type::longdouble_ : arg_type::double_;
+                c.simple = !flags && !width && c.conv != 'a' && c.conv != 'A';
+                break;
+            default: return false;
+        }
+
+        // Keep a nul terminated spec for snprintf
+        c.offset = m_text.size();
+        c.len = i - begin;
+        m_text.append(f + begin, c.len);
+        m_text.push_back('\0');
+        m_conversions.push_back(c);
+        literal = i;
+    }
+    addLiteral(literal, i);
+    return true;
+}
+
+void printf_format::render(memory_buffer & buffer, va_list args) const
+{
+    const char * text = m_text.data();
+    for (auto & c : m_conversions) {
+        switch (c.arg) {
+            case arg_type::none: buffer.append(text + c.offset, text + c.offset + c.len); break;
+            case arg_type::int_:
+                if (c.isUnsigned) {
+                    unsigned value = va_arg(args, unsigned);
+                    if (c.narrow == 1)
+                        value = static_cast<unsigned char>(value);
+                    else if (c.narrow == 2)
+                        value = static_cast<unsigned short>(value);
+                    appendInteger(buffer, c, value);
+                } else {
+                    int value = va_arg(args, int);
+                    if (c.narrow == 1)
+                        value = static_cast<signed char>(value);
+                    else if (c.narrow == 2)
+                        value = static_cast<short>(value);
+                    appendInteger(buffer, c, value);
+                }
+                break;
+            case arg_type::long_:
+                if (c.isUnsigned)
+                    appendInteger(buffer, c, va_arg(args, unsigned long));
+                else
+                    appendInteger(buffer, c, va_arg(args, long));
+                break;
+            case arg_type::longlong_:
+                if (c.isUnsigned)
+                    appendInteger(buffer, c, va_arg(args, unsigned long long));
+                else
+                    appendInteger(buffer, c, va_arg(args, long long));
+                break;
+            case arg_type::intmax_:
+                if (c.isUnsigned)
+                    appendInteger(buffer, c, va_arg(args, uintmax_t));
+                else
+                    appendInteger(buffer, c, va_arg(args, intmax_t));
+                break;
+            case arg_type::size_:
+                if (c.isUnsigned)
+                    appendInteger(buffer, c, va_arg(args, size_t));
+                else
+                    appendInteger(buffer, c, va_arg(args, std::make_signed<size_t>::type));
+                break;
+            case arg_type::ptrdiff_:
+                if (c.isUnsigned)
+                    appendInteger(buffer, c, va_arg(args, std::make_unsigned<ptrdiff_t>::type));
+                else
+                    appendInteger(buffer, c, va_arg(args, ptrdiff_t));
+                break;
+            case arg_type::double_: appendFloat(buffer, c, va_arg(args, double)); break;
+            case arg_type::longdouble_: appendSnprintf(buffer, c, va_arg(args, long double)); break;
+            case arg_type::string_: appendString(buffer, c, va_arg(args, const char *)); break;
+            case arg_type::pointer_: appendSnprintf(buffer, c, va_arg(args, void *)); break;
+        }
+    }
+}
+
+template<typename T>
+void printf_format::appendInteger(memory_buffer & buffer, const conversion & c, T value) const
+{
+    if (!c.simple)
+        return appendSnprintf(buffer, c, value);
+    switch (c.conv) {
+        case 'c': buffer.push_back(static_cast<char>(value)); break;
+        case 'x': appendBase<4>(buffer, value, "0123456789abcdef"); break;
+        case 'X': appendBase<4>(buffer, value, "0123456789ABCDEF"); break;
+        case 'o': appendBase<3>(buffer, value, "01234567"); break;
+        default: {
+            fmt::format_int i(value);
+            buffer.append(i.data(), i.data() + i.size());
+        }
+    }
+}
+
+void printf_format::appendFloat(memory_buffer & buffer, const conversion & c, double value) const
+{
+    if (!c.simple)
+        return appendSnprintf(buffer, c, value);
+    const int precision = c.precision < 0 ? 6 : c.precision;
+    auto out = fmt::appender(buffer);
+    switch (c.conv) {
+        case 'f': fmt::format_to(out, "{:.{}f}", value, precision); break;
+        case 'F': fmt::format_to(out, "{:.{}F}", value, precision); break;
+        case 'e': fmt::format_to(out, "{:.{}e}", value, precision); break;
+        case 'E': fmt::format_to(out, "{:.{}E}", value, precision); break;
+        case 'g': fmt::format_to(out, "{:.{}g}", value, precision); break;
+        case 'G': fmt::format_to(out, "{:.{}G}", value, precision); break;
+    }
+}
+
+void printf_format::appendString(memory_buffer & buffer, const conversion & c,
+                                 const char * value) const
+{
+    // Null strings are rendered the platform way
+    if (!c.simple || !value)
+        return appendSnprintf(buffer, c, value);
+    size_t len = 0;
+    if (c.precision < 0) {
+        len = strlen(value);
+    } else {
+        // The string may not be nul terminated past the precision
+        while (len < static_cast<size_t>(c.precision) && value[len])
+            len++;
+    }
+    buffer.append(value, value + len);
+}
+
+template<typename T>
+void printf_format::appendSnprintf(memory_buffer & buffer, const conversion & c, T value) const
+{
+    const char * spec = m_text.data() + c.offset;
+    const size_t size = buffer.size();
+    int len = snprintf(buffer.data() + size, buffer.capacity() - size, spec, value);
+    if (len < 0)
+        return;
+    if (size + len >= buffer.capacity()) {
+        buffer.reserve(size + len + 1);
+        snprintf(buffer.data() + size, len + 1, spec, value);
+    }
+    buffer.resize(size + len);
+}
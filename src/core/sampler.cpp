@@ -0,0 +1,75 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "sampler.h"
+
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+using namespace simplelog;
+
+namespace {
+// Logs of a level between two checks of the clock, for target rates
+const uint64_t checkInterval = 64;
+const int64_t windowNs = 1000000000;
+
+int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+} // namespace
+
+sampler::sampler(const sample_rates & rates)
+{
+    const int64_t start = now();
+    for (size_t i = 0; i < m_levels.size(); i++) {
+        level_state & l = m_levels[i];
+        l.rate = rates[i];
+        // Target rates keep all logs until the first rate is observed
+        l.every = rates[i].perSecond > 0 ? 1 : rates[i].every;
+        l.seen = 0;
+        l.windowSeen = 0;
+        l.windowStart = start;
+    }
+}
+
+bool sampler::any(const sample_rates & rates)
+{
+    for (const auto & r : rates) {
+        if (r.enabled())
+            return true;
+    }
+    return false;
+}
+
+void sampler::adapt(level_state & l)
+{
+    const uint64_t seen = l.seen.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (seen % checkInterval != 0)
+        return;
+    const int64_t t = now();
+    int64_t start = l.windowStart.load(std::memory_order_relaxed);
+    // Adapt every second, or as soon as the logs kept in the window exceed the target
+    const uint64_t count = seen - l.windowSeen.load(std::memory_order_relaxed);
+    const unsigned every = l.every.load(std::memory_order_relaxed);
+    if ((t - start < windowNs && count / every <= l.rate.perSecond) || t <= start
+        || !l.windowStart.compare_exchange_strong(start, t))
+        return;
+    l.windowSeen.store(seen, std::memory_order_relaxed);
+    const double rate = count * 1e9 / (t - start);
+    const double target = std::ceil(rate / l.rate.perSecond);
+    l.every.store(target > 1 ? static_cast<unsigned>(target) : 1, std::memory_order_relaxed);
+}
+
+uint64_t sampler::seed()
+{
+    // Distinct per thread, and per process
+    static std::atomic<uint64_t> sequence(static_cast<uint64_t>(now()));
+    uint64_t s = sequence.fetch_add(0x9E3779B97F4A7C15ull, std::memory_order_relaxed)
+                 ^ std::hash<std::thread::id>()(std::this_thread::get_id());
+    return s ? s : 1;
+}
@@ -0,0 +1,232 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "site_profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+#include "allocator.h"
+#include "config.h"
+#include "logger.h"
+
+using namespace simplelog;
+
+std::atomic_bool site_profiler::m_enabled(false);
+
+namespace {
+using site_key = std::tuple<const char *, const char *, int, int>; // file, tag, line, level
+
+// Sites of a thread, in an open addressing table only written by that thread.
+// Other threads read an entry once it's published, and its counters without ordering.
+class thread_sites
+{
+public:
+    struct entry
+    {
+        std::atomic_bool used;
+        const char * tag;
+        log_level level;
+        const char * file;
+        int line;
+        std::atomic<uint64_t> records;
+        std::atomic<uint64_t> bytes;
+    };
+    static const size_t capacity = 1024;
+
+    thread_sites();
+    ~thread_sites();
+
+    entry & find(const char * tag, log_level level, const char * file, int line)
+    {
+        size_t h = reinterpret_cast<uintptr_t>(file) ^ reinterpret_cast<uintptr_t>(tag)
+                   ^ (static_cast<size_t>(line) << 4) ^ static_cast<size_t>(level);
+        h *= 0x9E3779B97F4A7C15ull;
+        for (size_t i = 0; i < capacity; i++) {
+            entry & e = m_entries[(h + i) % capacity];
+            if (!e.used.load(std::memory_order_relaxed)) {
+                e.tag = tag;
+                e.level = level;
+                e.file = file;
+                e.line = line;
+                e.used.store(true, std::memory_order_release);
+                return e;
+            }
+            if (e.file == file && e.line == line && e.tag == tag && e.level == level)
+                return e;
+        }
+        // Full table, the site is counted as unknown
+        return m_overflow;
+    }
+
+    // Add counters to totals, by site
+    void collect(std::map<site_key, site_profiler::site> & totals) const;
+
+private:
+    entry m_entries[capacity];
+    entry m_overflow;
+};
+
+struct registry
+{
+    std::mutex mutex;
+    std::vector<thread_sites *> threads;
+    // Counters of exited threads
+    std::map<site_key, site_profiler::site> exited;
+    // Next periodic summary, in steady clock milliseconds
+    std::atomic<int64_t> nextSummary{ 0 };
+    std::atomic<unsigned> summaryInterval{ 0 };
+};
+
+registry & sites()
+{
+    // Never destroyed, as threads may exit after static destructors
+    static registry * r = new registry();
+    return *r;
+}
+
+int64_t nowMs()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+thread_sites::thread_sites()
+{
+    for (auto & e : m_entries) {
+        e.used = false;
+        e.records = 0;
+        e.bytes = 0;
+    }
+    m_overflow.tag = "?";
+    m_overflow.level = log_level::verbose;
+    m_overflow.file = "?";
+    m_overflow.line = 0;
+    m_overflow.records = 0;
+    m_overflow.bytes = 0;
+    m_overflow.used = true;
+    registry & r = sites();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.threads.push_back(this);
+}
+
+thread_sites::~thread_sites()
+{
+    registry & r = sites();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    collect(r.exited);
+    r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), this), r.threads.end());
+}
+
+void thread_sites::collect(std::map<site_key, site_profiler::site> & totals) const
+{
+    auto add = [&totals](const entry & e) {
+        if (!e.used.load(std::memory_order_acquire) || e.records.load() == 0)
+            return;
+        auto & s = totals[site_key(e.file, e.tag, e.line, e.level)];
+        s.tag = e.tag;
+        s.level = e.level;
+        s.file = e.file;
+        s.line = e.line;
+        s.records += e.records.load(std::memory_order_relaxed);
+        s.bytes += e.bytes.load(std::memory_order_relaxed);
+    };
+    for (auto & e : m_entries)
+        add(e);
+    add(m_overflow);
+}
+} // namespace
+
+void site_profiler::configure(bool enabled, unsigned summaryInterval)
+{
+    registry & r = sites();
+    if (r.summaryInterval.exchange(summaryInterval) != summaryInterval)
+        r.nextSummary = nowMs() + summaryInterval * 1000ll;
+    m_enabled = enabled;
+}
+
+void site_profiler::record(const char * tag, log_level level, const char * file, int line,
+                           size_t bytes)
+{
+    static thread_local std::unique_ptr<thread_sites, memory_deleter> local;
+    static thread_local unsigned untilClock = 0;
+    if (!local)
+        local.reset(memory::create<thread_sites>());
+    auto & e = local->find(tag, level, file ? file : "?", line);
+    // Only the owner thread writes, so that the counters don't need atomic additions
+    e.records.store(e.records.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    e.bytes.store(e.bytes.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+
+    // The clock is only read once every 256 lines of a thread
+    registry & r = sites();
+    if (r.summaryInterval.load(std::memory_order_relaxed) == 0 || untilClock-- != 0)
+        return;
+    untilClock = 255;
+    int64_t next = r.nextSummary.load(std::memory_order_relaxed);
+    const int64_t now = nowMs();
+    if (now >= next
+        && r.nextSummary.compare_exchange_strong(next, now + r.summaryInterval * 1000ll))
+        summarize();
+}
+
+std::vector<site_profiler::site> site_profiler::top(size_t count)
+{
+    std::map<site_key, site> totals;
+    {
+        registry & r = sites();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        totals = r.exited;
+        for (auto t : r.threads)
+            t->collect(totals);
+    }
+    std::vector<site> ret;
+    ret.reserve(totals.size());
+    for (auto & t : totals)
+        ret.push_back(t.second);
+    std::sort(ret.begin(), ret.end(), [](const site & a, const site & b) {
+        return a.bytes != b.bytes ? a.bytes > b.bytes : a.records > b.records;
+    });
+    if (ret.size() > count)
+        ret.resize(count);
+    return ret;
+}
+
+void site_profiler::summarize()
+{
+    static const size_t count = 5;
+    auto m = reinterpret_cast<module *>(_simplelog_create("simplelog", nullptr));
+    memory_buffer summary;
+    fmt::format_to(fmt::appender(summary), FMT_COMPILE("Top log sites:"));
+    for (const auto & s : top(count)) {
+        fmt::format_to(fmt::appender(summary), FMT_COMPILE(" {}:{} [{}/{}] {} lines {} bytes;"),
+                       s.file, s.line, s.tag, static_cast<int>(s.level), s.records, s.bytes);
+    }
+    m->logFormatted(log_level::info, __FILE__, __func__, __LINE__,
+                    string_view(summary.data(), summary.size()));
+}
+
+extern "C" void _simplelog_site_profiling(int enable, unsigned summary_interval)
+{
+    config::get().setSiteProfiling(enable != 0, summary_interval);
+    site_profiler::configure(enable != 0, summary_interval);
+}
+
+extern "C" void _simplelog_top_sites(size_t count,
+                                     void (*callback)(const struct simplelog_site * site,
+                                                      void * ctx),
+                                     void * ctx)
+{
+    if (!callback)
+        return;
+    for (const auto & s : site_profiler::top(count)) {
+        simplelog_site site{ s.file, s.line, s.tag, static_cast<int>(s.level), s.records,
+                             s.bytes };
+        callback(&site, ctx);
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "stage_timing.h"
+
+#include "config.h"
+#include "logger.h"
+
+using namespace simplelog;
+
+std::atomic<unsigned> stage_timing::m_interval(0);
+stage_timing::histogram stage_timing::m_histograms[static_cast<int>(stage::count)];
+
+namespace {
+// Logs between two checks of the sampling interval while timing is disabled
+const unsigned disabledCountdown = 65536;
+} // namespace
+
+void stage_timing::setSampling(unsigned interval)
+{
+    m_interval.store(interval, std::memory_order_relaxed);
+}
+
+bool stage_timing::resample(unsigned & countdown)
+{
+    const unsigned interval = m_interval.load(std::memory_order_relaxed);
+    countdown = interval ? interval : disabledCountdown;
+    return interval != 0;
+}
+
+void stage_timing::add(stage s, int64_t ns)
+{
+    const uint64_t duration = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    int bucket = 0;
+    while (bucket < bucketCount - 1 && duration >> (bucket + 1))
+        bucket++;
+    histogram & h = m_histograms[static_cast<int>(s)];
+    h.samples.fetch_add(1, std::memory_order_relaxed);
+    h.totalNs.fetch_add(duration, std::memory_order_relaxed);
+    h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    uint64_t current = h.maxNs.load(std::memory_order_relaxed);
+    while (duration > current
+           && !h.maxNs.compare_exchange_weak(current, duration, std::memory_order_relaxed)) {}
+}
+
+const char * stage_timing::name(stage s)
+{
+    static const char * names[] = { "message", "line", "lock", "consume", "queue", "write" };
+    return names[static_cast<int>(s)];
+}
+
+extern "C" void _simplelog_stage_timing(unsigned sampling)
+{
+    config::get().setStageTiming(sampling);
+    stage_timing::setSampling(sampling);
+}
+
+extern "C" void _simplelog_stage_timings(void (*callback)(const struct simplelog_stage * stage,
+                                                          void * ctx),
+                                         void * ctx)
+{
+    if (!callback)
+        return;
+    for (int i = 0; i < static_cast<int>(stage::count); i++) {
+        const stage s = static_cast<stage>(i);
+        const stage_timing::histogram & h = stage_timing::get(s);
+        simplelog_stage timing = {};
+        timing.name = stage_timing::name(s);
+        timing.samples = h.samples.load(std::memory_order_relaxed);
+        timing.total_ns = h.totalNs.load(std::memory_order_relaxed);
+        timing.max_ns = h.maxNs.load(std::memory_order_relaxed);
+        for (int b = 0; b < stage_timing::bucketCount; b++)
+            timing.buckets[b] = h.buckets[b].load(std::memory_order_relaxed);
+        callback(&timing, ctx);
+    }
+}
@@ -6,14 +6,15 @@
 
 using namespace simplelog;
 
-void sync_consumer::consume(log_level level, const char * msg, size_t len)
+bool sync_consumer::consume(log_level level, const char * msg, size_t len)
 {
     for (auto & logger : m_loggers)
-        logger->logRaw(level, msg, len);
+        logger->writeRaw(level, msg, len);
+    return true;
 }
 
 void sync_consumer::flush()
 {
     for (auto & logger : m_loggers)
-        logger->flush();
+        logger->flushRaw();
 }
@@ -0,0 +1,91 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_TAG_MATCHER
+#define SIMPLELOG_TAG_MATCHER
+
+#include <memory>
+#include <string>
+
+#include "casecmp.h"
+
+namespace simplelog {
+
+// Trie of dotted tag patterns, such as "net", "net.http.client", "net.*" or "db.*.pool".
+// A "*" segment matches any single segment, and a pattern also matches all the tags below it
+// ("net" matches "net.http.client"). When several patterns match, the one matching the most
+// segments wins, literal segments being preferred over "*" at the first difference.
+template<class Val>
+class tag_matcher
+{
+public:
+    void clear() { m_root = node(); }
+
+    void add(const std::string & pattern, const Val * value)
+    {
+        node * n = &m_root;
+        size_t cur = 0;
+        while (true) {
+            size_t next = pattern.find('.', cur);
+            if (next == std::string::npos)
+                next = pattern.size();
+            std::string segment = pattern.substr(cur, next - cur);
+            auto & child = segment == "*" ? n->wildcard : n->children[segment];
+            if (!child)
+                child = std::make_unique<node>();
+            n = child.get();
+            if (next == pattern.size())
+                break;
+            cur = next + 1;
+        }
+        n->value = value;
+    }
+
+    const Val * find(const std::string & tag) const
+    {
+        match m{ tag, std::string(), nullptr, 0 };
+        find(m_root, m, 0, 0);
+        return m.best;
+    }
+
+private:
+    struct node
+    {
+        unordered_casemap<std::unique_ptr<node>> children;
+        std::unique_ptr<node> wildcard;
+        const Val * value = nullptr;
+    };
+    struct match
+    {
+        const std::string & tag;
+        std::string segment;
+        const Val * best;
+        size_t bestDepth;
+    };
+
+    static void find(const node & n, match & m, size_t pos, size_t depth)
+    {
+        if (n.value && (depth > m.bestDepth || !m.best)) {
+            m.best = n.value;
+            m.bestDepth = depth;
+        }
+        if (pos > m.tag.size())
+            return;
+        size_t next = m.tag.find('.', pos);
+        if (next == std::string::npos)
+            next = m.tag.size();
+        m.segment.assign(m.tag, pos, next - pos);
+        auto child = n.children.find(m.segment);
+        if (child != n.children.end())
+            find(*child->second, m, next + 1, depth + 1);
+        if (n.wildcard)
+            find(*n.wildcard, m, next + 1, depth + 1);
+    }
+
+    node m_root;
+};
+
+} // namespace simplelog
+
+#endif
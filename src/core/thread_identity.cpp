@@ -0,0 +1,65 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include "thread_identity.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fmt/format.h>
+#include <thread>
+
+#include "logger.h"
+#include "os.h"
+
+using namespace simplelog;
+
+thread_identity::thread_identity() : m_tid(0), m_length(0), m_name(), m_text() {}
+
+thread_identity & thread_identity::current()
+{
+    static thread_local thread_identity identity;
+    return identity;
+}
+
+const thread_identity & thread_identity::get()
+{
+    thread_identity & identity = current();
+    if (identity.m_length == 0) {
+        identity.m_tid = os::getThreadId();
+        identity.render();
+    }
+    return identity;
+}
+
+void thread_identity::setName(const char * name)
+{
+    thread_identity & identity = current();
+    // Longer names are truncated
+    size_t len = name ? strnlen(name, m_maxNameLength) : 0;
+    std::copy(name, name + len, identity.m_name);
+    identity.m_name[len] = '\0';
+    identity.m_tid = os::getThreadId();
+    identity.render();
+}
+
+void thread_identity::reset()
+{
+    os::resetThreadId();
+    thread_identity & identity = current();
+    identity.m_tid = os::getThreadId();
+    identity.render();
+}
+
+void thread_identity::render()
+{
+    fmt::format_int tid(m_tid);
+    char * p = std::copy(tid.data(), tid.data() + tid.size(), m_text);
+    if (m_name[0]) {
+        *p++ = ':';
+        p = std::copy(m_name, m_name + strlen(m_name), p);
+    }
+    m_length = p - m_text;
+}
+
+extern "C" void _simplelog_set_thread_name(const char * name) { thread_identity::setName(name); }
@@ -4,6 +4,7 @@
  */
 #include "default_formatter.h"
 
+#include <algorithm>
 #include <iostream>
 #include <string.h>
 
@@ -11,42 +12,67 @@ using namespace simplelog;
 
 default_formatter_factory default_formatter_factory::instance;
 
-void default_formatter::formatPrefix(std::mutex & mutex, const log_metadata & metadata,
-                                     memory_buffer & formatted)
+default_formatter::thread_cache & default_formatter::cache()
+{
+    // The timestamp text doesn't depend on the formatter instance, so it's shared by all of them
+    static thread_local thread_cache c;
+    return c;
+}
+
+void default_formatter::formatPrefix(const log_metadata & metadata, memory_buffer & formatted)
 {
     formatted.push_back('[');
     formatted.push_back(logLevelToChar(metadata.level));
     formatted.push_back(']');
 
-    {
-        std::lock_guard<std::mutex> lock(mutex);
-        if (shouldUpdateSeconds(metadata)) {
-            m_seconds.clear();
-            m_seconds.push_back('[');
-            appendDecimal(m_seconds, metadata.year, 4);
-            m_seconds.push_back('-');
-            appendDecimal(m_seconds, metadata.month, 2);
-            m_seconds.push_back('-');
-            appendDecimal(m_seconds, metadata.day, 2);
-            m_seconds.push_back(' ');
-            appendDecimal(m_seconds, metadata.hour, 2);
-            m_seconds.push_back(':');
-            appendDecimal(m_seconds, metadata.minute, 2);
-            m_seconds.push_back(':');
-            appendDecimal(m_seconds, metadata.second, 2);
-            m_seconds.push_back('.');
+    thread_cache & c = cache();
+    if (shouldUpdateSeconds(c.time, metadata)) {
+        // "[YYYY-MM-DD HH:MM:SS." or "[<epoch>."
+        char * p = c.seconds;
+        *p++ = '[';
+        if (metadata.timestamp == timestamp_mode::epoch) {
+            fmt::format_int epoch(metadata.epoch);
+            p = std::copy(epoch.data(), epoch.data() + epoch.size(), p);
+        } else {
+            p = render::fourDigits(p, metadata.year % 10000);
+            *p++ = '-';
+            p = render::twoDigits(p, metadata.month);
+            *p++ = '-';
+            p = render::twoDigits(p, metadata.day);
+            *p++ = ' ';
+            p = render::twoDigits(p, metadata.hour);
+            *p++ = ':';
+            p = render::twoDigits(p, metadata.minute);
+            *p++ = ':';
+            p = render::twoDigits(p, metadata.second);
         }
-        if (shouldUpdateMilliseconds(metadata)) {
-            m_milliseconds.clear();
-            appendDecimal(m_milliseconds, metadata.millisecond, 3);
-            m_milliseconds.push_back(']');
-        }
-        append(formatted, m_seconds);
-        append(formatted, m_milliseconds);
+        *p++ = '.';
+        c.secondsLength = p - c.seconds;
+    }
+    formatted.append(c.seconds, c.seconds + c.secondsLength);
+    if (metadata.precision == timestamp_precision::ms) {
+        if (shouldUpdateMilliseconds(c.time, metadata))
+            render::threeDigits(c.milliseconds, metadata.millisecond);
+        formatted.append(c.milliseconds, c.milliseconds + sizeof(c.milliseconds));
+    } else {
+        // Sub-millisecond digits change with almost every log, so they aren't cached
+        char fraction[9];
+        const bool us = metadata.precision == timestamp_precision::us;
+        const unsigned value = metadata.nanosecond / (us ? 1000 : 1);
+        char * end = render::digits(fraction, value, us ? 6 : 9);
+        formatted.append(fraction, end);
     }
+    if (metadata.timestamp == timestamp_mode::utc)
+        formatted.push_back('Z');
+    formatted.push_back(']');
 
     formatted.push_back('[');
-    appendDecimal(formatted, metadata.tid);
+    if (!c.identity)
+        c.identity = &thread_identity::get();
+    if (c.identity->tid() == metadata.tid)
+        formatted.append(c.identity->data(), c.identity->data() + c.identity->size());
+    else
+        render::decimal(formatted, metadata.tid);
     formatted.push_back(']');
     formatted.push_back('[');
     formatted.append(metadata.tag, metadata.tag + strlen(metadata.tag));
@@ -54,20 +80,17 @@ void default_formatter::formatPrefix(std::mutex & mutex, const log_metadata & me
     formatted.push_back(' ');
 }
 
-void default_formatter::format(std::mutex & mutex, const log_metadata & metadata,
-                               memory_buffer & formatted, const char * msg, va_list args)
+void default_formatter::format(const log_metadata & metadata, memory_buffer & formatted,
+                               const char * msg, va_list args)
 {
-    formatPrefix(mutex, metadata, formatted);
-    std::array<char, LOG_MAX_LINE_LENGTH> buf;
-    int len = vsnprintf(buf.data(), buf.size(), msg, args);
-    if (len >= 0)
-        formatted.append(buf.data(), buf.data() + len);
+    formatPrefix(metadata, formatted);
+    appendPrintf(formatted, msg, args);
 }
 
-void default_formatter::format(std::mutex & mutex, const log_metadata & metadata, string_view msg,
+void default_formatter::format(const log_metadata & metadata, string_view msg,
                                memory_buffer & formatted)
 {
-    formatPrefix(mutex, metadata, formatted);
+    formatPrefix(metadata, formatted);
     formatted.append(msg.data(), msg.data() + msg.size());
 }
 
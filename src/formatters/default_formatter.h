@@ -9,23 +9,32 @@
 #include <vector>
 #include "formatter.h"
 #include "logger.h"
+#include "thread_identity.h"
 
 namespace simplelog {
 
 class default_formatter : public iformatter
 {
 public:
-    virtual void format(std::mutex & mutex, const log_metadata & metadata,
-                        memory_buffer & formatted, const char * msg, va_list args) override final;
-    virtual void format(std::mutex & mutex, const log_metadata & metadata, string_view msg,
+    virtual void format(const log_metadata & metadata, memory_buffer & formatted, const char * msg,
+                        va_list args) override final;
+    virtual void format(const log_metadata & metadata, string_view msg,
                         memory_buffer & formatted) override final;
 
 private:
-    void formatPrefix(std::mutex & mutex, const log_metadata & metadata, memory_buffer & formatted);
+    // Timestamp text last rendered by a thread, only rebuilt when the timestamp changes
+    struct thread_cache
+    {
+        rendered_time time;
+        char seconds[24]; // "[YYYY-MM-DD HH:MM:SS." or "[<epoch>."
+        size_t secondsLength = 0;
+        char milliseconds[3];
+        const thread_identity * identity = nullptr; // Saves a thread local lookup per log
+    };
+
+    void formatPrefix(const log_metadata & metadata, memory_buffer & formatted);
     char logLevelToChar(log_level level) const;
-
-    memory_buffer m_seconds;
-    memory_buffer m_milliseconds;
+    static thread_cache & cache();
 };
 
 class default_formatter_factory : public formatter_factory
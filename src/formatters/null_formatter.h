@@ -15,9 +15,9 @@ namespace simplelog {
 class null_formatter : public iformatter
 {
 public:
-    virtual void format(std::mutex & mutex, const log_metadata & metadata,
-                        memory_buffer & formatted, const char * msg, va_list args) override final;
-    virtual void format(std::mutex & mutex, const log_metadata & metadata, string_view msg,
+    virtual void format(const log_metadata & metadata, memory_buffer & formatted, const char * msg,
+                        va_list args) override final;
+    virtual void format(const log_metadata & metadata, string_view msg,
                         memory_buffer & formatted) override final;
 };
 
@@ -4,6 +4,7 @@
  */
 #include "file_logger.h"
 
+#include <cstring>
 #include <iostream>
 
 using namespace simplelog;
@@ -12,23 +13,88 @@ file_logger_factory file_logger_factory::instance;
 std::string file_logger::m_defaultPath = "/tmp/logs.txt";
 
 file_logger::file_logger(const std::string & tag, const std::string & path) :
-    logger(tag), m_file(fopen(path.empty() ? m_defaultPath.c_str() : path.c_str(), "wb"))
-{}
+    logger(tag),
+    m_path(path.empty() ? m_defaultPath : path),
+    m_file(nullptr),
+    m_fd(-1),
+    m_used(0)
+{
+    open();
+}
 
 file_logger::~file_logger()
 {
+    if (!m_file)
+        return;
+    writeBuffer();
+    fclose(m_file);
+}
+
+void file_logger::open()
+{
+    m_file = fopen(processPath(m_path).c_str(), "wb");
+    m_fd = m_file ? fileno(m_file) : -1;
     if (m_file)
-        fclose(m_file);
+        setvbuf(m_file, nullptr, _IONBF, 0);
 }
 
 void file_logger::flush()
 {
-    if (m_file)
-        fflush(m_file);
+    if (!m_file)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    writeBuffer();
 }
 
 void file_logger::logRaw(log_level, const char * msg, size_t len)
 {
+    if (!m_file)
+        return;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_used + len > sizeof(m_buffer)) {
+        writeBuffer();
+        if (len > sizeof(m_buffer)) {
+            fwrite(msg, 1, len, m_file);
+            return;
+        }
+    }
+    memcpy(m_buffer + m_used, msg, len);
+    m_used += len;
+}
+
+void file_logger::writeBuffer()
+{
+    if (m_used)
+        fwrite(m_buffer, 1, m_used, m_file);
+    m_used = 0;
+}
+
+void file_logger::crashFlush()
+{
+    // Without lock, as the crashing thread may hold it
+    if (m_fd >= 0 && m_used)
+        os::writeFd(m_fd, m_buffer, m_used);
+    m_used = 0;
+}
+
+void file_logger::afterFork()
+{
+    // Per process files are reopened, the others are shared with the parent
+    if (m_path.find("%p") == std::string::npos)
+        return;
     if (m_file)
-        fwrite(msg, 1, len, m_file);
+        fclose(m_file);
+    m_used = 0;
+    open();
+}
+
+std::string file_logger::processPath(const std::string & path)
+{
+    std::string ret = path;
+    const std::string pid = std::to_string(os::getProcessId());
+    for (size_t pos = ret.find("%p"); pos != std::string::npos; pos = ret.find("%p", pos)) {
+        ret.replace(pos, 2, pid);
+        pos += pid.size();
+    }
+    return ret;
 }
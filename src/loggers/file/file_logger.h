@@ -6,6 +6,7 @@
 #define SIMPLELOG_FILE_LOGGER
 
 #include <fstream>
+#include <mutex>
 #include <stdio.h>
 #include "logger.h"
 
@@ -22,9 +23,27 @@ public:
 protected:
     virtual void logRaw(log_level level, const char * msg, size_t len) override final;
     virtual void flush() override final;
+    virtual int crashFd() const override final { return m_fd; }
+    virtual void crashFlush() override final;
+    virtual void afterFork() override final;
 
 private:
+    // Path with "%p" replaced by the process id
+    static std::string processPath(const std::string & path);
+    // Open the file unbuffered, as lines are buffered by the logger
+    void open();
+    // Write the buffered lines to the file, with m_mutex locked
+    void writeBuffer();
+
+    const std::string m_path;
     FILE * m_file;
+    int m_fd;
+    // Lines are buffered here rather than by the stdio stream, so that the crash handler can
+    // write them out with write(2) whatever the libc. Engines sharing the logger may write
+    // concurrently.
+    std::mutex m_mutex;
+    size_t m_used;
+    char m_buffer[8192];
     static std::string m_defaultPath;
 };
 
@@ -10,7 +10,9 @@ using namespace simplelog;
 
 stdout_logger_factory stdout_logger_factory::instance;
 
-stdout_logger::stdout_logger(const std::string & tag) : logger(tag), m_file(stdout) {}
+stdout_logger::stdout_logger(const std::string & tag) :
+    logger(tag), m_file(stdout), m_fd(fileno(stdout))
+{}
 
 void stdout_logger::logRaw(log_level, const char * msg, size_t len) { fwrite(msg, 1, len, m_file); }
 
@@ -17,9 +17,12 @@ public:
 protected:
     virtual void logRaw(log_level level, const char * msg, size_t len) override final;
     virtual void flush() override final;
+    virtual int crashFd() const override final { return m_fd; }
+    virtual void crashFlush() override final { os::drainFile(m_file, m_fd); }
 
 private:
     FILE * m_file;
+    int m_fd;
 };
 
 class stdout_logger_factory : public logger_factory
@@ -0,0 +1,65 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <atomic>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+#include "logger_engine.h"
+#include "test_logger.h"
+
+using namespace simplelog;
+using namespace testing;
+
+class allocation_tests : public Test
+{
+protected:
+    allocation_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+#ifdef __GLIBC__
+namespace {
+std::atomic_bool countAllocations(false);
+std::atomic<size_t> allocations(0);
+} // namespace
+
+// Count all allocations, from any thread, while countAllocations is set. Built in its own
+// executable, as malloc is replaced for the whole process.
+extern "C" void * __libc_malloc(size_t size);
+extern "C" void * malloc(size_t size)
+{
+    if (countAllocations)
+        allocations++;
+    return __libc_malloc(size);
+}
+
+TEST_F(allocation_tests, async_engine)
+{
+    auto engine = std::make_shared<logger_engine>(log_level::verbose,
+                                                  formatter_factory::get("Default"),
+                                                  std::vector<std::shared_ptr<logger>>{ m_logger });
+    engine->setAsync();
+    logger & l = *engine;
+    auto logLoop = [&](int count) {
+        for (int i = 0; i < count; i++)
+            l.log(log_level::info, __FILE__, __func__, __LINE__, "message {} {}", i, 0.5);
+    };
+    // Let slabs be allocated for the whole loop, while the writer thread is blocked
+    m_logger->m_blocked = true;
+    logLoop(10000);
+    m_logger->m_blocked = false;
+    l.flush();
+
+    allocations = 0;
+    countAllocations = true;
+    logLoop(5000);
+    l.flush();
+    countAllocations = false;
+    ASSERT_EQ(allocations, 0u);
+    ASSERT_EQ(m_logger->m_records, 15000u);
+}
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <cstring>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "async_consumer.h"
+#include "logger_engine.h"
+#include "test_logger.h"
+
+using namespace simplelog;
+using namespace testing;
+
+class async_backend_tests : public Test
+{
+protected:
+    async_backend_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(async_backend_tests, records_written)
+{
+    async_consumer consumer({ m_logger });
+    std::string big(200000, 'x'); // bigger than a slab
+    for (int i = 0; i < 1000; i++)
+        consumer.consume(log_level::info, "message", 7);
+    consumer.consume(log_level::info, big.c_str(), big.size());
+    consumer.flush();
+    ASSERT_EQ(m_logger->m_records, 1001u);
+    ASSERT_EQ(m_logger->m_bytes, 7000u + big.size());
+}
+
+TEST_F(async_backend_tests, shared_loggers)
+{
+    async_consumer consumer1({ m_logger });
+    async_consumer consumer2({ m_logger });
+    for (int i = 0; i < 1000; i++) {
+        consumer1.consume(log_level::info, "message1", 8);
+        consumer2.consume(log_level::info, "message2", 8);
+    }
+    consumer1.flush();
+    ASSERT_EQ(m_logger->m_records, 2000u);
+}
+
+TEST_F(async_backend_tests, detach_flush)
+{
+    {
+        async_consumer consumer({ m_logger });
+        consumer.consume(log_level::info, "message", 7);
+    }
+    ASSERT_EQ(m_logger->m_records, 1u);
+    ASSERT_EQ(m_logger->sinkMetrics().flushes.get(), 1u);
+}
+
+TEST_F(async_backend_tests, queue_limit_per_engine)
+{
+    auto quiet = std::make_shared<test_logger>();
+    async_consumer noisyConsumer({ m_logger });
+    async_consumer quietConsumer({ quiet });
+    // A full queue only drops the logs of its engine
+    m_logger->m_blocked = true;
+    for (int i = 0; i < LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE + 100; i++)
+        noisyConsumer.consume(log_level::info, "noisy", 5);
+    for (int i = 0; i < 100; i++)
+        quietConsumer.consume(log_level::info, "quiet", 5);
+    m_logger->m_blocked = false;
+    noisyConsumer.flush();
+    ASSERT_EQ(quiet->m_records, 100u);
+    ASSERT_GT(m_logger->m_records, static_cast<size_t>(LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE));
+    ASSERT_LT(m_logger->m_records, static_cast<size_t>(LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE + 100));
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+#include "call_site.h"
+#include "logger_engine.h"
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+class test_logger : public logger
+{
+public:
+    test_logger() : logger("Test"), m_records(0), m_bytes(0) {}
+
+    virtual void logRaw(log_level, const char *, size_t len) override
+    {
+        m_records++;
+        m_bytes += len;
+    }
+
+    std::atomic<size_t> m_records;
+    std::atomic<size_t> m_bytes;
+};
+} // namespace
+
+class call_site_tests : public Test
+{
+protected:
+    call_site_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(call_site_tests, rate_limit)
+{
+    auto engine = std::make_shared<logger_engine>(log_level::verbose, formatter_factory::get("Null"),
+                                                  std::vector<std::shared_ptr<logger>>{ m_logger });
+    const rate_limit limit(3, 3600);
+    module limited("limited", log_level::verbose, engine, &limit);
+    _simplelog_site site = {};
+    for (int i = 0; i < 100; i++)
+        limited.log(site, log_level::info, __FILE__, __func__, __LINE__, "message {}", i);
+    ASSERT_EQ(m_logger->m_records, 3u);
+    ASSERT_EQ(site.dropped, 97u);
+    // The count of dropped logs is written on flush, without another log of the site
+    call_site::reportPending();
+    ASSERT_EQ(m_logger->m_records, 4u);
+    ASSERT_EQ(site.dropped, 0u);
+
+    // Only duplicates are folded without interval
+    const rate_limit fold;
+    module folded("folded", log_level::verbose, engine, &fold);
+    site = {};
+    for (int i = 0; i < 10; i++)
+        folded.log(site, log_level::info, __FILE__, __func__, __LINE__, "message {}", 0);
+    ASSERT_EQ(m_logger->m_records, 5u);
+    // The next message is written after the count of folded ones
+    folded.log(site, log_level::info, __FILE__, __func__, __LINE__, "message {}", 1);
+    ASSERT_EQ(m_logger->m_records, 7u);
+    ASSERT_EQ(site.repeats, 0u);
+
+    // Or the count is written once the folding window expired
+    for (int i = 0; i < 3; i++)
+        folded.log(site, log_level::info, __FILE__, __func__, __LINE__, "message {}", 1);
+    ASSERT_EQ(site.repeats, 3u);
+    for (int i = 0; i < 500 && m_logger->m_records != 8u; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    ASSERT_EQ(m_logger->m_records, 8u);
+    ASSERT_EQ(site.repeats, 0u);
+    call_site::reportPending();
+}
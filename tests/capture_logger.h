@@ -0,0 +1,82 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_TESTS_CAPTURE_LOGGER
+#define SIMPLELOG_TESTS_CAPTURE_LOGGER
+
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "logger.h"
+
+namespace simplelog {
+
+// Logger keeping the lines written to it, for tests expanding the logging macros.
+// The modules of the macros get it through the configuration, like any other logger.
+class capture_logger : public logger
+{
+public:
+    capture_logger() : logger("Capture") {}
+
+    virtual void logRaw(log_level, const char * msg, size_t len) override
+    {
+        const size_t eol = strlen(os::getEol());
+        std::lock_guard<std::mutex> lock(mutex());
+        lines().emplace_back(msg, len >= eol ? len - eol : len);
+    }
+
+    // Route the logs of tag, at any level, to the capture logger, with messages written as is
+    static void route(const std::string & tag)
+    {
+        static factory instance;
+        _simplelog_register_logger("Capture", "Capture", "");
+        config & c = config::get();
+        c.setAsync(false);
+        c.setFormatter("Null");
+        c.update(std::make_unique<std::stringstream>("[LEVELS]\n" + tag + " = verbose,Capture\n"));
+        take();
+    }
+    static void restore() { config::get().setFormatter("Default"); }
+
+    // Lines written since the previous call
+    static std::vector<std::string> take()
+    {
+        std::lock_guard<std::mutex> lock(mutex());
+        std::vector<std::string> ret;
+        ret.swap(lines());
+        return ret;
+    }
+
+private:
+    class factory : public logger_factory
+    {
+    public:
+        factory() : logger_factory("Capture") {}
+        virtual std::shared_ptr<logger> getLogger(const std::string &,
+                                                  const std::string &) override
+        {
+            return std::make_shared<capture_logger>();
+        }
+    };
+
+    static std::mutex & mutex()
+    {
+        static std::mutex m;
+        return m;
+    }
+    static std::vector<std::string> & lines()
+    {
+        static std::vector<std::string> l;
+        return l;
+    }
+};
+
+} // namespace simplelog
+
+#endif
@@ -0,0 +1,7 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+// Format strings checked at build time, and compiled when the C++ standard allows it
+#define FORMAT_TESTS compiled_format_tests
+#include "format_tests.h"
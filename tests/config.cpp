@@ -69,6 +69,37 @@ TEST_F(config_tests, general_formatter)
     ASSERT_EQ(m_config.formatter(), "coucou");
 }
 
+TEST_F(config_tests, general_timestamp)
+{
+    update("[General]\n"
+           "Timestamp = UTC\n"
+           "Precision = us\n");
+    ASSERT_EQ(m_config.timestampMode(), timestamp_mode::utc);
+    ASSERT_EQ(m_config.timestampPrecision(), timestamp_precision::us);
+
+    update("[general]\n"
+           "timestamp = epoch\n"
+           "precision = seconds\n");
+    ASSERT_EQ(m_config.timestampMode(), timestamp_mode::epoch);
+    ASSERT_EQ(m_config.timestampPrecision(), timestamp_precision::us);
+
+    m_config.setTimestamp(timestamp_mode::local, timestamp_precision::ms);
+    ASSERT_EQ(m_config.timestampMode(), timestamp_mode::local);
+    ASSERT_EQ(m_config.timestampPrecision(), timestamp_precision::ms);
+}
+
+TEST_F(config_tests, general_load_shedding)
+{
+    update("[General]\n"
+           "Load_shedding = 90,50,70\n");
+    ASSERT_EQ(m_config.loadShedding(), std::vector<unsigned>({ 50, 70, 90 }));
+
+    // Invalid percents are ignored
+    update("[general]\n"
+           "load_shedding = 0,120,x,80\n");
+    ASSERT_EQ(m_config.loadShedding(), std::vector<unsigned>({ 80 }));
+}
+
 TEST_F(config_tests, general_unknown)
 {
     update("[General]\n"
@@ -212,6 +243,44 @@ TEST_F(config_tests, tags_errors)
                                                  UnorderedElementsAre("Console", "FileTmp"))))));
 }
 
+TEST_F(config_tests, rate_limits)
+{
+    update("[RateLimit]\n"
+           "net = 100/s\n"
+           "db.*.pool = 30/m\n"
+           "fold = 0\n"
+           "bad = 10/day\n");
+    auto limit = m_config.findRateLimit("net.http");
+    ASSERT_NE(limit, nullptr);
+    ASSERT_EQ(limit->intervalNs, 10000000);
+    ASSERT_EQ(limit->toleranceNs, 99 * 10000000ll);
+    limit = m_config.findRateLimit("db.main.pool");
+    ASSERT_NE(limit, nullptr);
+    ASSERT_EQ(limit->intervalNs, 2000000000);
+    limit = m_config.findRateLimit("fold");
+    ASSERT_NE(limit, nullptr);
+    ASSERT_EQ(limit->intervalNs, 0);
+    ASSERT_EQ(m_config.findRateLimit("bad"), nullptr);
+    ASSERT_EQ(m_config.findRateLimit("db"), nullptr);
+}
+
+TEST_F(config_tests, tags_samples)
+{
+    update("[LEVELS]\n"
+           "chatty = debug,sample=10\n"
+           "net = sample=debug:100,sample=verbose:50/s,sample=bad:3,sample=\n");
+    auto t = m_config.findTag("chatty");
+    ASSERT_NE(t, nullptr);
+    ASSERT_EQ(t->level, log_level::debug);
+    for (const auto & s : t->samples)
+        ASSERT_EQ(s.every, 10u);
+    t = m_config.findTag("net.http");
+    ASSERT_NE(t, nullptr);
+    ASSERT_EQ(t->samples[log_level::debug].every, 100u);
+    ASSERT_EQ(t->samples[log_level::verbose].perSecond, 50);
+    ASSERT_FALSE(t->samples[log_level::info].enabled());
+}
+
 TEST_F(config_tests, tags_loggers_modified)
 {
     update("[LOGGERS]\n"
@@ -238,3 +307,55 @@ TEST_F(config_tests, tags_loggers_modified)
                                                         Field(&config::tag::loggers,
                                                               UnorderedElementsAre("FileTmp"))))));
 }
+
+TEST_F(config_tests, tags_hierarchy)
+{
+    update("[LOGGERS]\n"
+           "Console = Stdout\n"
+           "FileTmp = File\n"
+           "[Levels]\n"
+           "* = error\n"
+           "net = warning\n"
+           "net.http = info\n"
+           "net.http.client = debug,FileTmp\n");
+    ASSERT_EQ(m_config.findTag("net")->level, log_level::warning);
+    ASSERT_EQ(m_config.findTag("NET.Http")->level, log_level::info);
+    ASSERT_EQ(m_config.findTag("net.http.client")->level, log_level::debug);
+    ASSERT_THAT(m_config.findTag("net.http.client")->loggers, UnorderedElementsAre("FileTmp"));
+    ASSERT_EQ(m_config.findTag("net.http.server")->level, log_level::info);
+    ASSERT_EQ(m_config.findTag("net.udp")->level, log_level::warning);
+    ASSERT_EQ(m_config.findTag("network")->level, log_level::error);
+    ASSERT_EQ(m_config.findTag("db")->level, log_level::error);
+}
+
+TEST_F(config_tests, tags_wildcards)
+{
+    update("[LOGGERS]\n"
+           "Console = Stdout\n"
+           "[Levels]\n"
+           "db.* = warning\n"
+           "db.*.pool = debug\n"
+           "db.main.pool = panic\n"
+           "*.pool = info\n");
+    ASSERT_EQ(m_config.findTag("db"), nullptr);
+    ASSERT_EQ(m_config.findTag("db.main")->level, log_level::warning);
+    ASSERT_EQ(m_config.findTag("db.main.pool")->level, log_level::panic);
+    ASSERT_EQ(m_config.findTag("db.replica.pool")->level, log_level::debug);
+    ASSERT_EQ(m_config.findTag("db.replica.pool.conn")->level, log_level::debug);
+    ASSERT_EQ(m_config.findTag("db.replica.cache")->level, log_level::warning);
+    ASSERT_EQ(m_config.findTag("net.pool")->level, log_level::info);
+    ASSERT_EQ(m_config.findTag("pool"), nullptr);
+}
+
+TEST_F(config_tests, tags_default_fallback)
+{
+    update("[LOGGERS]\n"
+           "Console = Stdout\n"
+           "[Levels]\n"
+           "koko = debug\n");
+    ASSERT_EQ(m_config.findTag("kaka"), nullptr);
+    m_config.setDefaultLevel(log_level::warning);
+    ASSERT_EQ(m_config.findTag("kaka")->level, log_level::warning);
+    ASSERT_EQ(m_config.findTag("koko")->level, log_level::debug);
+    ASSERT_EQ(m_config.findTag("koko.sub")->level, log_level::debug);
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "crash_handler.h"
+#include "file_logger.h"
+#include "logger_engine.h"
+#include "test_logger.h"
+
+using namespace simplelog;
+using namespace testing;
+
+class crash_handler_tests : public Test
+{
+protected:
+    crash_handler_tests() : m_path(testing::TempDir() + "simplelog_crash.txt")
+    {
+        GTEST_FLAG_SET(death_test_style, "threadsafe");
+    }
+    ~crash_handler_tests() { std::remove(m_path.c_str()); }
+
+    std::string logs() const
+    {
+        std::ifstream file(m_path);
+        std::stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+
+    const std::string m_path;
+};
+
+#ifdef __GLIBC__
+// Logger writing to a stdio file, and to it only from the crash handler while blocked.
+// The data buffered by the stream is only known on glibc.
+class fd_logger : public test_logger
+{
+public:
+    explicit fd_logger(const std::string & path) : m_file(fopen(path.c_str(), "wb")) {}
+    ~fd_logger() { fclose(m_file); }
+
+    virtual void logRaw(log_level level, const char * msg, size_t len) override
+    {
+        test_logger::logRaw(level, msg, len);
+        fwrite(msg, 1, len, m_file);
+    }
+    virtual int crashFd() const override { return fileno(m_file); }
+    virtual void crashFlush() override { os::drainFile(m_file, fileno(m_file)); }
+
+    FILE * m_file;
+};
+
+TEST_F(crash_handler_tests, stdio_buffer)
+{
+    EXPECT_EXIT(
+            {
+                auto l = std::make_shared<fd_logger>(m_path);
+                logger_engine engine(log_level::verbose, formatter_factory::get("Null"), { l });
+                engine.setAsync();
+                crash_handler::install(true);
+                // The first record is written to the stdio buffer, the others stay queued
+                l->logRaw(log_level::info, "buffered\n", 9);
+                l->m_blocked = true;
+                for (int i = 0; i < 10; i++)
+                    engine.log(log_level::info, __FILE__, __func__, __LINE__, "queued {}", i);
+                raise(SIGSEGV);
+            },
+            KilledBySignal(SIGSEGV), "");
+
+    const std::string l = logs();
+    ASSERT_THAT(l, StartsWith("buffered\n"));
+    ASSERT_THAT(l, HasSubstr("queued 9\nFATAL: Signal SIGSEGV received, backtrace:\n"));
+}
+#endif
+
+#ifndef _WIN32
+TEST_F(crash_handler_tests, file_logger)
+{
+    EXPECT_EXIT(
+            {
+                // The file is only written from the crash handler while the other logger blocks
+                auto blocking = std::make_shared<test_logger>();
+                auto file = std::make_shared<simplelog::file_logger>("crash", m_path);
+                logger_engine engine(log_level::verbose, formatter_factory::get("Null"),
+                                     { blocking, file });
+                // The first record is kept in the buffer of the logger, the others stay queued
+                engine.log(log_level::info, __FILE__, __func__, __LINE__, "buffered");
+                engine.setAsync();
+                crash_handler::install(true);
+                blocking->m_blocked = true;
+                for (int i = 0; i < 10; i++)
+                    engine.log(log_level::info, __FILE__, __func__, __LINE__, "queued {}", i);
+                raise(SIGSEGV);
+            },
+            KilledBySignal(SIGSEGV), "");
+
+    const std::string l = logs();
+    ASSERT_THAT(l, StartsWith("buffered\nqueued 0\n"));
+    ASSERT_THAT(l, HasSubstr("queued 9\nFATAL: Signal SIGSEGV received, backtrace:\n"));
+}
+#endif
@@ -0,0 +1,75 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "logger_engine.h"
+#include "test_logger.h"
+#include "thread_identity.h"
+
+using namespace simplelog;
+using namespace testing;
+
+class fork_tests : public Test
+{
+protected:
+    fork_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+#ifndef _WIN32
+TEST_F(fork_tests, writer_restarted)
+{
+    logger_engine engine(log_level::verbose, formatter_factory::get("Null"), { m_logger });
+    engine.setAsync();
+    logger & l = engine;
+    for (int i = 0; i < 100; i++)
+        l.log(log_level::info, __FILE__, __func__, __LINE__, "message");
+    thread_identity::setName("forker");
+    // Lines of the forking thread, with its identity cached by the formatter
+    auto formatLine = [] {
+        log_metadata m = {};
+        m.tag = "tag";
+        m.level = log_level::info;
+        m.tid = os::getThreadId();
+        m.filename = m.funcname = "";
+        memory_buffer formatted;
+        formatter_factory::get("Default")->format(m, "msg", formatted);
+        return std::string(formatted.data(), formatted.size());
+    };
+    ASSERT_THAT(formatLine(), HasSubstr(":forker]"));
+    // Queued records are written before forking, and only by the parent
+    const pid_t pid = fork();
+    if (pid == 0) {
+        bool ok = m_logger->m_records == 100u;
+        // The child has its own writer thread, and its own thread ids
+        l.log(log_level::info, __FILE__, __func__, __LINE__, "child");
+        l.flush();
+        ok = ok && m_logger->m_records == 101u;
+#ifdef __linux__
+        ok = ok && os::getThreadId() == static_cast<size_t>(getpid());
+        // The name of the forking thread is kept, with its new id
+        const std::string identity = "[" + std::to_string(getpid()) + ":forker]";
+        ok = ok && formatLine().find(identity) != std::string::npos;
+#endif
+        _exit(ok ? 0 : 1);
+    }
+    thread_identity::setName(nullptr);
+    ASSERT_GT(pid, 0);
+    int status = 0;
+    ASSERT_EQ(waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+    l.flush();
+    ASSERT_EQ(m_logger->m_records, 100u);
+}
+#endif
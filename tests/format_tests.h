@@ -0,0 +1,60 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+// Formatting tests of the C++ logging macros, shared by the test translation units building them
+// with and without LOG_RUNTIME_FORMAT. FORMAT_TESTS is defined as the test suite name.
+#include <fmt/format.h>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <string>
+
+#include "capture_logger.h"
+#include "logger.h"
+
+#define FORMAT_TESTS_NAME(suite) FORMAT_TESTS_NAME_IMPL(suite)
+#define FORMAT_TESTS_NAME_IMPL(suite) #suite
+
+SLOG_DECLARE_MODULE(FORMAT_TESTS_NAME(FORMAT_TESTS));
+
+class FORMAT_TESTS : public testing::Test
+{
+protected:
+    FORMAT_TESTS() { simplelog::capture_logger::route(FORMAT_TESTS_NAME(FORMAT_TESTS)); }
+    ~FORMAT_TESTS() { simplelog::capture_logger::restore(); }
+};
+
+TEST_F(FORMAT_TESTS, same_as_fmt)
+{
+    const std::string str = "str";
+    SLOGI("{} {:>5} {:.3f} {:#x} {}", 1, "ab", 3.14159, 255, str);
+    SLOGW("{:<4}|{:^7}|{:+}", 'c', true, -2);
+    SLOGE("{}", 42u);
+    ASSERT_THAT(simplelog::capture_logger::take(),
+                testing::ElementsAre(fmt::format("{} {:>5} {:.3f} {:#x} {}", 1, "ab", 3.14159,
+                                                 255, str),
+                                     fmt::format("{:<4}|{:^7}|{:+}", 'c', true, -2),
+                                     fmt::format("{}", 42u)));
+}
+
+TEST_F(FORMAT_TESTS, escaped_braces)
+{
+    SLOGI("{{}} {}", 1);
+    SLOGI("{{}}");
+    ASSERT_THAT(simplelog::capture_logger::take(), testing::ElementsAre("{} 1", "{}"));
+}
+
+// Up to 62 arguments are dispatched to the formatting path
+TEST_F(FORMAT_TESTS, max_arguments)
+{
+    SLOGI("{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} "
+          "{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} "
+          "{} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {} {}",
+          0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24,
+          25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46,
+          47, 48, 49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61);
+    std::string expected;
+    for (int i = 0; i < 62; i++)
+        expected += (i ? " " : "") + std::to_string(i);
+    ASSERT_THAT(simplelog::capture_logger::take(), testing::ElementsAre(expected));
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+
+#include "formatter.h"
+#include "os.h"
+#include "printf_format.h"
+#include "thread_identity.h"
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+std::string formatPrintf(const char * msg, ...)
+{
+    memory_buffer formatted;
+    va_list args;
+    va_start(args, msg);
+    formatter_factory::get("Null")->format(log_metadata(), formatted, msg, args);
+    va_end(args);
+    return std::string(formatted.data(), formatted.size());
+}
+
+std::string formatDefault(const log_metadata & metadata)
+{
+    memory_buffer formatted;
+    formatter_factory::get("Default")->format(metadata, "msg", formatted);
+    return std::string(formatted.data(), formatted.size());
+}
+
+// Render msg with a freshly compiled format, and check it's the same as vsnprintf
+void expectCompiled(const char * msg, ...)
+{
+    void * cache = nullptr;
+    auto format = printf_format::get(&cache, msg);
+    ASSERT_NE(format, nullptr) << msg;
+    va_list args, copy;
+    va_start(args, msg);
+    va_copy(copy, args);
+    memory_buffer rendered;
+    format->render(rendered, args);
+    char expected[512];
+    vsnprintf(expected, sizeof(expected), msg, copy);
+    va_end(copy);
+    va_end(args);
+    EXPECT_EQ(std::string(rendered.data(), rendered.size()), expected) << msg;
+}
+} // namespace
+
+TEST(formatter_tests, default_timestamp)
+{
+    // 2021-01-01 00:00:05.012345678 UTC
+    log_metadata m{ "tag", log_level::info, 42, "file", "func", 1, 2021, 1, 1, 0, 0, 5, 12,
+                    12345678, 1609459205, timestamp_mode::local, timestamp_precision::ms };
+    ASSERT_EQ(formatDefault(m), "[I][2021-01-01 00:00:05.012][42][tag] msg");
+    m.precision = timestamp_precision::us;
+    ASSERT_EQ(formatDefault(m), "[I][2021-01-01 00:00:05.012345][42][tag] msg");
+    m.timestamp = timestamp_mode::utc;
+    m.precision = timestamp_precision::ns;
+    ASSERT_EQ(formatDefault(m), "[I][2021-01-01 00:00:05.012345678Z][42][tag] msg");
+    m.timestamp = timestamp_mode::epoch;
+    m.precision = timestamp_precision::ms;
+    ASSERT_EQ(formatDefault(m), "[I][1609459205.012][42][tag] msg");
+}
+
+TEST(formatter_tests, default_thread_name)
+{
+    std::thread([] {
+        const std::string tid = std::to_string(os::getThreadId());
+        log_metadata m{ "tag", log_level::info, os::getThreadId(), "file", "func", 1, 2021, 1, 1,
+                        0, 0, 5, 12, 12345678, 1609459205, timestamp_mode::local,
+                        timestamp_precision::ms };
+        ASSERT_EQ(formatDefault(m), "[I][2021-01-01 00:00:05.012][" + tid + "][tag] msg");
+        thread_identity::setName("io-worker-3");
+        ASSERT_EQ(formatDefault(m),
+                  "[I][2021-01-01 00:00:05.012][" + tid + ":io-worker-3][tag] msg");
+        thread_identity::setName(nullptr);
+        ASSERT_EQ(formatDefault(m), "[I][2021-01-01 00:00:05.012][" + tid + "][tag] msg");
+    }).join();
+}
+
+TEST(formatter_tests, printf_short)
+{
+    ASSERT_EQ(formatPrintf("value %d, %s", 42, "text"), "value 42, text");
+}
+
+TEST(formatter_tests, printf_long)
+{
+    std::string longText(10 * LOG_MAX_LINE_LENGTH, 'x');
+    ASSERT_EQ(formatPrintf("begin %s end %d", longText.c_str(), 7),
+              "begin " + longText + " end 7");
+}
+
+TEST(formatter_tests, printf_compiled)
+{
+    expectCompiled("no conversion");
+    expectCompiled("%d %i %u %x %X %o %c %%", -42, 7, 42u, 0xbeefu, 0xbeefu, 8u, 'z');
+    expectCompiled("%hhd %hd %hhu %hu", 300, 70000, 300, 70000);
+    expectCompiled("%ld %lu %lld %llx %jd %zu %zd %td", LONG_MIN, ULONG_MAX, LLONG_MIN,
+                   ULLONG_MAX, INTMAX_MAX, SIZE_MAX, (ptrdiff_t)-1, (ptrdiff_t)-5);
+    expectCompiled("%s|%.3s|%.10s|%s", "text", "truncated", "short", (const char *)nullptr);
+    expectCompiled("%f %.2f %.0f %.0f %e %.3E %g %G %g %g", 3.14159, 2.675, 0.5, 1.5, 12345.678,
+                   0.000123, 100000.0, 1e-5, 1e20, 0.0001);
+    expectCompiled("%f %f %f %g", INFINITY, -INFINITY, NAN, -0.0);
+    expectCompiled("%5d|%-5d|%05d|%+d|% d|%.3d|%#x|%#o", 1, 2, 3, 4, 5, 6, 255u, 8u);
+    expectCompiled("%10s|%-10s|%10.2f|%-8.3e|%#g|%a|%Lf", "r", "l", 3.14159, 1234.5, 1.0, 1.0,
+                   (long double)2.5);
+    expectCompiled("%p %p", (void *)0x1234, (void *)nullptr);
+}
+
+TEST(formatter_tests, printf_not_compiled)
+{
+    void * cache = nullptr;
+    ASSERT_EQ(printf_format::get(&cache, "%*d"), nullptr);
+    ASSERT_EQ(printf_format::get(&cache, "%*d"), nullptr);
+    void * other = nullptr;
+    ASSERT_EQ(printf_format::get(&other, "%2$d %1$d"), nullptr);
+    void * wide = nullptr;
+    ASSERT_EQ(printf_format::get(&wide, "%ls"), nullptr);
+}
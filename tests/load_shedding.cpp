@@ -0,0 +1,112 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "load_shedding.h"
+#include "logger_engine.h"
+#include "test_logger.h"
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+// Logger keeping the queue fill percentages reported by the asynchronous backend
+class report_logger : public test_logger
+{
+public:
+    virtual void logRaw(log_level level, const char * msg, size_t len) override
+    {
+        test_logger::logRaw(level, msg, len);
+        const std::string line(msg, len);
+        const size_t pos = line.find("Log queue ");
+        if (pos == std::string::npos)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_fills.push_back(std::stoi(line.substr(pos + 10)));
+    }
+
+    std::mutex m_mutex;
+    std::vector<int> m_fills;
+};
+} // namespace
+
+class load_shedding_tests : public Test
+{
+protected:
+    load_shedding_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    static std::shared_ptr<logger_engine> asyncEngine(const std::shared_ptr<logger> & l)
+    {
+        auto engine = std::make_shared<logger_engine>(
+                log_level::verbose, formatter_factory::get("Null"),
+                std::vector<std::shared_ptr<logger>>{ l });
+        engine->setAsync();
+        return engine;
+    }
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(load_shedding_tests, shed_levels)
+{
+    auto engine = asyncEngine(m_logger);
+    module shed("shed", log_level::verbose, engine);
+    load_shedding::setWatermarks({ 1, 2, 3 });
+    // Fill the queue past all the watermarks, while the writer thread is blocked
+    m_logger->m_blocked = true;
+    size_t count = 0;
+    for (; load_shedding::level() != log_level::warning && count < LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE;
+         count++)
+        shed.log(log_level::warning, __FILE__, __func__, __LINE__, "message");
+    ASSERT_EQ(load_shedding::level(), log_level::warning);
+    shed.log(log_level::info, __FILE__, __func__, __LINE__, "message");
+    shed.log(log_level::debug, __FILE__, __func__, __LINE__, "message");
+    shed.log(log_level::error, __FILE__, __func__, __LINE__, "message");
+    ASSERT_EQ(engine->metrics().records.get(), count + 1);
+
+    // Levels are restored once the queue is drained
+    m_logger->m_blocked = false;
+    shed.flush();
+    ASSERT_EQ(load_shedding::level(), log_level::verbose);
+    shed.log(log_level::verbose, __FILE__, __func__, __LINE__, "message");
+    ASSERT_EQ(engine->metrics().records.get(), count + 2);
+    load_shedding::setWatermarks({});
+}
+
+TEST_F(load_shedding_tests, fill_per_engine)
+{
+    auto reports = std::make_shared<report_logger>();
+    module shed1("shed1", log_level::verbose, asyncEngine(reports));
+    module shed2("shed2", log_level::verbose, asyncEngine(m_logger));
+    load_shedding::setWatermarks({ 60, 70, 80 });
+    // Engines filled at half their queue each don't reach the first watermark
+    reports->m_blocked = true;
+    for (int i = 0; i < LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE / 2; i++) {
+        shed1.log(log_level::warning, __FILE__, __func__, __LINE__, "message");
+        shed2.log(log_level::warning, __FILE__, __func__, __LINE__, "message");
+    }
+    const log_level halfLevel = load_shedding::level();
+    // The fullest engine sheds the logs of all of them
+    for (int i = 0; i < LOG_ASYNCHRONOUS_MAX_QUEUE_SIZE; i++)
+        shed1.log(log_level::warning, __FILE__, __func__, __LINE__, "message");
+    const log_level fullLevel = load_shedding::level();
+    reports->m_blocked = false;
+    shed1.flush();
+    shed2.flush();
+    load_shedding::setWatermarks({});
+
+    ASSERT_EQ(halfLevel, log_level::verbose);
+    ASSERT_EQ(fullLevel, log_level::warning);
+    ASSERT_THAT(reports->m_fills, Not(IsEmpty()));
+    for (int fill : reports->m_fills) {
+        ASSERT_GE(fill, 0);
+        ASSERT_LE(fill, 100);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <sstream>
+
+#include "capture_logger.h"
+#include "logger.h"
+
+SLOG_DECLARE_MODULE("logger_tests");
+
+extern "C" void logger_c_literals(void);
+extern "C" void logger_c_runtime(const char * msg);
+
+using namespace simplelog;
+using namespace testing;
+
+class logger_tests : public Test
+{
+protected:
+    logger_tests() { capture_logger::route("logger_tests"); }
+    ~logger_tests() { capture_logger::restore(); }
+};
+
+TEST_F(logger_tests, plain_literal)
+{
+    static_assert(literal("100% done").plain(), "no braces to unescape");
+    static_assert(!literal("{{escaped}}").plain(), "braces to unescape");
+    SLOGI("100% done");
+    SLOGI("{{escaped}}");
+    ASSERT_THAT(capture_logger::take(), ElementsAre("100% done", "{escaped}"));
+}
+
+TEST_F(logger_tests, c_literal)
+{
+    // Constant messages without '%' are written as is, the others are printf-formatted
+    logger_c_literals();
+    ASSERT_THAT(capture_logger::take(),
+                ElementsAre("{} written as is", "100% formatted", "100% formatted"));
+}
+
+TEST_F(logger_tests, c_runtime)
+{
+    // Messages built at runtime are always printf-formatted
+    char msg[] = "100%% formatted";
+    logger_c_runtime(msg);
+    ASSERT_THAT(capture_logger::take(), ElementsAre("100% formatted"));
+}
+
+TEST_F(logger_tests, config_change)
+{
+    auto before = reinterpret_cast<module *>(_simplelog_create("logger_tests.config", nullptr));
+    ASSERT_EQ(_simplelog_create("logger_tests.config", nullptr), before);
+    config::get().update(
+            std::make_unique<std::stringstream>("[LEVELS]\nlogger_tests.config = info,Capture\n"));
+    // Modules declared after a configuration change get the new one
+    auto after = reinterpret_cast<module *>(_simplelog_create("logger_tests.config", nullptr));
+    ASSERT_NE(after, before);
+    after->logFormatted(log_level::debug, __FILE__, __func__, __LINE__, "debug after");
+    after->logFormatted(log_level::info, __FILE__, __func__, __LINE__, "info after");
+    // Modules declared before keep theirs
+    before->logFormatted(log_level::debug, __FILE__, __func__, __LINE__, "debug before");
+    ASSERT_THAT(capture_logger::take(), ElementsAre("info after", "debug before"));
+}
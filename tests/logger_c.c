@@ -0,0 +1,17 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+// C logging macros, called from the logger tests
+#include "logger.h"
+
+SLOG_DECLARE_MODULE("logger_tests.c");
+
+void logger_c_literals(void)
+{
+    SLOGI("{} written as is");
+    SLOGI("100%% formatted");
+    SLOGI("%d%% formatted", 100);
+}
+
+void logger_c_runtime(const char * msg) { SLOGI(msg); }
@@ -0,0 +1,47 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "capture_logger.h"
+#include "logger.h"
+
+SLOG_DECLARE_MODULE("max_level_tests", SLOG_MAX_LEVEL(LOG_LEVEL_INFO));
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+int evaluate(int & count) { return ++count; }
+} // namespace
+
+class max_level_tests : public Test
+{
+protected:
+    max_level_tests() { capture_logger::route("max_level_tests"); }
+    ~max_level_tests() { capture_logger::restore(); }
+};
+
+TEST_F(max_level_tests, above_max_level)
+{
+    // Arguments of logs above the max level are never evaluated
+    int count = 0;
+    SLOGV("verbose {}", evaluate(count));
+    SLOGD("debug {}", evaluate(count));
+    SLOG_RATE_LIMIT(LOG_LEVEL_DEBUG, 10, "limited {}", evaluate(count));
+    ASSERT_EQ(count, 0);
+    ASSERT_THAT(capture_logger::take(), IsEmpty());
+}
+
+TEST_F(max_level_tests, up_to_max_level)
+{
+    int count = 0;
+    SLOGI("info {}", evaluate(count));
+    SLOGW("warning {}", evaluate(count));
+    SLOGE("error {}", evaluate(count));
+    SLOG_RATE_LIMIT(LOG_LEVEL_INFO, 10, "limited {}", evaluate(count));
+    ASSERT_EQ(count, 4);
+    ASSERT_THAT(capture_logger::take(), ElementsAre("info 1", "warning 2", "error 3", "limited 4"));
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "logger_engine.h"
+#include "test_logger.h"
+
+using namespace simplelog;
+using namespace testing;
+
+class metrics_tests : public Test
+{
+protected:
+    metrics_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(metrics_tests, engine_and_sink)
+{
+    logger_engine engine(log_level::verbose, formatter_factory::get("Null"), { m_logger });
+    engine.setAsync();
+    logger & l = engine;
+    m_logger->m_blocked = true;
+    for (int i = 0; i < 100; i++)
+        l.log(log_level::info, __FILE__, __func__, __LINE__, "message");
+    uint64_t depth, maxDepth;
+    engine.queueDepth(depth, maxDepth);
+    ASSERT_GE(maxDepth, depth);
+    ASSERT_GT(maxDepth, 0u);
+    m_logger->m_blocked = false;
+    l.flush();
+
+    engine.queueDepth(depth, maxDepth);
+    ASSERT_EQ(depth, 0u);
+    ASSERT_EQ(engine.metrics().records.get(), 100u);
+    const size_t bytes = 100 * (strlen("message") + strlen(os::getEol()));
+    ASSERT_EQ(engine.metrics().bytes.get(), bytes);
+    ASSERT_EQ(engine.metrics().drops.get(), 0u);
+    ASSERT_EQ(engine.metrics().flushes.get(), 1u);
+    ASSERT_EQ(m_logger->sinkMetrics().records.get(), 100u);
+    ASSERT_EQ(m_logger->sinkMetrics().bytes.get(), bytes);
+    ASSERT_EQ(m_logger->sinkMetrics().writeSamples.get(),
+              100u / sink_metrics::latencySampling + 1);
+}
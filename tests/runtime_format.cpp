@@ -0,0 +1,18 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+// Format strings parsed on each log, which may then be built at runtime
+#define LOG_RUNTIME_FORMAT
+#define FORMAT_TESTS runtime_format_tests
+#include "format_tests.h"
+
+TEST_F(runtime_format_tests, non_literal)
+{
+    const std::string format = std::string("{} ") + "{}";
+    const char * plain = "{{plain}}";
+    SLOGI(format.c_str(), 1, 2);
+    SLOGI(format, 3, 4);
+    SLOGI(plain);
+    ASSERT_THAT(simplelog::capture_logger::take(), testing::ElementsAre("1 2", "3 4", "{plain}"));
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <atomic>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+
+#include "logger_engine.h"
+#include "sampler.h"
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+class test_logger : public logger
+{
+public:
+    test_logger() : logger("Test"), m_records(0), m_bytes(0) {}
+
+    virtual void logRaw(log_level, const char *, size_t len) override
+    {
+        m_records++;
+        m_bytes += len;
+    }
+
+    std::atomic<size_t> m_records;
+    std::atomic<size_t> m_bytes;
+};
+} // namespace
+
+class sampler_tests : public Test
+{
+protected:
+    sampler_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(sampler_tests, sampled_levels)
+{
+    auto engine = std::make_shared<logger_engine>(log_level::verbose, formatter_factory::get("Null"),
+                                                  std::vector<std::shared_ptr<logger>>{ m_logger });
+    sample_rates samples;
+    samples[log_level::debug].every = 10;
+    module sampled("sampled", log_level::verbose, engine, nullptr, &samples);
+    _simplelog_site site = {};
+    for (int i = 0; i < 10000; i++)
+        sampled.log(site, log_level::debug, __FILE__, __func__, __LINE__, "message");
+    ASSERT_GT(m_logger->m_records, 700u);
+    ASSERT_LT(m_logger->m_records, 1300u);
+    // Kept lines are annotated with the sampling rate
+    ASSERT_EQ(m_logger->m_bytes, m_logger->m_records * (strlen("message [sampled 1/10]")
+                                                        + strlen(os::getEol())));
+
+    const size_t records = m_logger->m_records;
+    for (int i = 0; i < 100; i++)
+        sampled.log(site, log_level::info, __FILE__, __func__, __LINE__, "message {}", i);
+    ASSERT_EQ(m_logger->m_records, records + 100);
+}
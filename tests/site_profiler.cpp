@@ -0,0 +1,70 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <atomic>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "logger_engine.h"
+#include "site_profiler.h"
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+class test_logger : public logger
+{
+public:
+    test_logger() : logger("Test"), m_records(0), m_bytes(0) {}
+
+    virtual void logRaw(log_level, const char *, size_t len) override
+    {
+        m_records++;
+        m_bytes += len;
+    }
+
+    std::atomic<size_t> m_records;
+    std::atomic<size_t> m_bytes;
+};
+} // namespace
+
+class site_profiler_tests : public Test
+{
+protected:
+    site_profiler_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(site_profiler_tests, top_sites)
+{
+    logger_engine engine(log_level::verbose, formatter_factory::get("Null"), { m_logger });
+    logger & l = engine;
+    site_profiler::configure(true, 0);
+    int line = 0;
+    for (int i = 0; i < 3; i++) {
+        line = __LINE__ + 1;
+        l.log(log_level::info, __FILE__, __func__, line, "noisy");
+        std::thread([&] { l.log(log_level::info, __FILE__, __func__, line, "noisy"); }).join();
+    }
+    l.log(log_level::warning, __FILE__, __func__, __LINE__, "quiet");
+    site_profiler::configure(false, 0);
+    l.log(log_level::warning, __FILE__, __func__, __LINE__, "not counted");
+
+    std::vector<site_profiler::site> sites;
+    for (const auto & s : site_profiler::top(100)) {
+        if (strcmp(s.file, __FILE__) == 0)
+            sites.push_back(s);
+    }
+    ASSERT_EQ(sites.size(), 2u);
+    ASSERT_EQ(sites[0].line, line);
+    ASSERT_EQ(sites[0].level, log_level::info);
+    ASSERT_EQ(sites[0].records, 6u);
+    ASSERT_EQ(sites[0].bytes, 6 * (strlen("noisy") + strlen(os::getEol())));
+    ASSERT_EQ(sites[1].level, log_level::warning);
+    ASSERT_EQ(sites[1].records, 1u);
+}
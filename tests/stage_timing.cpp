@@ -0,0 +1,70 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#include <atomic>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+#include "logger_engine.h"
+#include "stage_timing.h"
+
+using namespace simplelog;
+using namespace testing;
+
+namespace {
+class test_logger : public logger
+{
+public:
+    test_logger() : logger("Test"), m_records(0), m_bytes(0) {}
+
+    virtual void logRaw(log_level, const char *, size_t len) override
+    {
+        m_records++;
+        m_bytes += len;
+    }
+
+    std::atomic<size_t> m_records;
+    std::atomic<size_t> m_bytes;
+};
+} // namespace
+
+class stage_timing_tests : public Test
+{
+protected:
+    stage_timing_tests() : m_logger(std::make_shared<test_logger>()) {}
+
+    std::shared_ptr<test_logger> m_logger;
+};
+
+TEST_F(stage_timing_tests, sampled_stages)
+{
+    logger_engine engine(log_level::verbose, formatter_factory::get("Null"), { m_logger });
+    engine.setAsync();
+    logger & l = engine;
+    uint64_t samples[static_cast<int>(stage::count)];
+    for (int i = 0; i < static_cast<int>(stage::count); i++)
+        samples[i] = stage_timing::get(static_cast<stage>(i)).samples;
+
+    // The countdown of a thread is only reset when it expires, so that logs are timed in a thread
+    // started after the sampling interval is set
+    stage_timing::setSampling(4);
+    std::thread([&] {
+        for (int i = 0; i < 100; i++)
+            l.log(log_level::info, __FILE__, __func__, __LINE__, "message {}", i);
+    }).join();
+    stage_timing::setSampling(0);
+    l.flush();
+
+    for (int i = 0; i < static_cast<int>(stage::count); i++) {
+        const stage_timing::histogram & h = stage_timing::get(static_cast<stage>(i));
+        ASSERT_EQ(h.samples - samples[i], 25u) << stage_timing::name(static_cast<stage>(i));
+        uint64_t buckets = 0;
+        for (auto & b : h.buckets)
+            buckets += b;
+        ASSERT_EQ(buckets, h.samples);
+        ASSERT_LE(h.maxNs, h.totalNs);
+    }
+}
@@ -0,0 +1,37 @@
+/*
+ * Copyright(c) 2020-present simplelog contributors.
+ * Distributed under the MIT License (http://opensource.org/licenses/MIT)
+ */
+#ifndef SIMPLELOG_TESTS_TEST_LOGGER
+#define SIMPLELOG_TESTS_TEST_LOGGER
+
+#include <atomic>
+#include <thread>
+
+#include "logger.h"
+
+namespace simplelog {
+
+// Logger counting the lines written to it. Writes wait while it's blocked, so that records pile
+// up in the asynchronous queue.
+class test_logger : public logger
+{
+public:
+    test_logger() : logger("Test"), m_blocked(false), m_records(0), m_bytes(0) {}
+
+    virtual void logRaw(log_level, const char *, size_t len) override
+    {
+        while (m_blocked)
+            std::this_thread::yield();
+        m_records++;
+        m_bytes += len;
+    }
+
+    std::atomic_bool m_blocked;
+    std::atomic<size_t> m_records;
+    std::atomic<size_t> m_bytes;
+};
+
+} // namespace simplelog
+
+#endif